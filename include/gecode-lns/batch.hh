@@ -0,0 +1,371 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_LNS_BATCH_HH__
+#define __GECODE_LNS_BATCH_HH__
+
+#include "gecode-lns/lns.hh"
+#include "gecode-lns/thread_pool.hh"
+#include <chrono>
+#include <mutex>
+
+namespace Gecode {
+
+  /**
+   * \brief Solve many independent instances with LNS on a shared thread pool
+   *
+   * Each instance runs its own LNS<E,T> meta-engine with an individual time
+   * budget. The budget is consumed in slices: after every slice the instance
+   * is resubmitted to the work-stealing pool unless its search is complete
+   * (the incumbent is optimal or within the gap, or there is no solution)
+   * or its budget is exhausted, so that workers freed by finished or
+   * converged instances immediately steal the pending ones. An initial
+   * solution search stopped at the end of a slice is resumed by the next
+   * one.
+   *
+   * Once every instance has been started, workers that would stay idle
+   * (more workers than running instances, or instances that finished)
+   * help the running instance with the fewest helpers: they run another
+   * LNS trajectory on it, with its own seed, in slices until the instance
+   * is done, and its solutions compete for the best one of the instance.
+   *
+   * Instance engines are built lazily inside the pool (hence in parallel)
+   * and run single-threaded, each on its own unshared copy of the model
+   * (copies are made one at a time, as copying updates the model);
+   * Search::Meta::LNS::lns_options must be set before run() and is shared
+   * by all instances. As the engines move between the workers of the pool,
+   * they have no phase profile or published metrics of their own, and their
+   * neighborhoods are traced into a single propagator profile of the batch.
+   */
+  template<template<class> class E, class T>
+  class LNSBatch {
+  protected:
+    /// An additional trajectory on an instance
+    class Helper {
+    public:
+      /// The stop object ending each slice
+      Search::DeadlineStop stop;
+      /// The options of the engine
+      Search::Options opt;
+      /// The unshared copy of the model the engine runs on
+      T* root;
+      /// The meta-engine
+      LNS<E,T>* engine;
+      /// The seed of the engine
+      unsigned int seed;
+      Helper(void) : stop(0), root(NULL), engine(NULL), seed(0) {}
+      ~Helper(void) { delete engine; delete root; }
+    };
+    /// An instance of the batch
+    class Instance {
+    public:
+      /// The model (the engines run on unshared copies of it)
+      T* s;
+      /// The unshared copy of the model the engine runs on
+      T* root;
+      /// The time budget (in milliseconds)
+      double budget;
+      /// The time used so far (in milliseconds)
+      double elapsed;
+      /// The stop object ending each slice
+      Search::DeadlineStop stop;
+      /// The options of the engine
+      Search::Options opt;
+      /// The meta-engine
+      LNS<E,T>* engine;
+      /// The best solution found so far
+      T* best;
+      /// Whether the search has been completed (by the engine or a helper)
+      bool complete;
+      /// Whether the instance is over (complete, or out of budget)
+      bool done;
+      /// The helpers
+      std::vector<Helper*> helpers;
+      /// Protects best and the model
+      std::mutex m;
+      Instance(T* s0, double budget0) : s(s0), root(NULL), budget(budget0), elapsed(0), stop(0), engine(NULL), best(NULL), complete(false), done(false) {}
+      ~Instance(void) {
+        for (unsigned int h = 0; h < helpers.size(); h++)
+          delete helpers[h];
+        delete engine; delete root; delete s; delete best;
+      }
+    };
+    /// The instances
+    std::vector<Instance*> instances;
+    /// The options the engine options are derived from
+    Search::Options opt;
+    /// The pool
+    Search::WorkStealingPool pool;
+    /// The length of a slice (in milliseconds)
+    double slice;
+    /// Protects the counters below, the engine pointers, and the done flags and helpers of the instances
+    std::mutex m;
+    /// Number of instances whose engine has been built
+    unsigned int started;
+    /// Number of instances and helpers being run (submitted, or running a slice)
+    unsigned int active;
+    /// Number of helpers created so far (for their seeds)
+    unsigned int helped;
+    /// The propagator profile of all the engines (created by run())
+    Search::Meta::PropagatorProfile* propagators;
+    /// Build an engine on \a s with options \a o, tracing into the profile of the batch
+    LNS<E,T>* engine(T* s, const Search::Options& o);
+    /// Return an unshared copy of the model of instance \a i (NULL if it fails, lock of \a i must be held)
+    static T* model(Instance* i);
+    /// Keep solution \a n of instance \a i if it is better than the best one, delete it otherwise
+    void keep(Instance* i, T* n);
+    /// Run one slice of instance \a i
+    void step(Instance* i);
+    /// Run one slice of helper \a h of instance \a i
+    void step(Instance* i, Helper* h);
+    /// Give the workers that would stay idle to running instances (lock must be held)
+    void help(void);
+  public:
+    /// Initialize a batch running on \a threads workers with slices of \a slice milliseconds
+    LNSBatch(const Search::Options& o, unsigned int threads, double slice = 100.0);
+    /// Delete instances and solutions
+    ~LNSBatch(void);
+    /// Add instance \a s (the batch takes ownership) with a budget of \a time milliseconds, return its index
+    unsigned int add(T* s, double time);
+    /// Solve all instances
+    void run(void);
+    /// Return the number of instances
+    unsigned int size(void) const;
+    /// Return the best solution of instance \a i (NULL if none has been found, owned by the batch)
+    const T* solution(unsigned int i) const;
+    /// Whether the search for instance \a i has been completed within its budget
+    bool complete(unsigned int i) const;
+    /// Return the time spent on instance \a i (in milliseconds)
+    double time(unsigned int i) const;
+    /// Return the statistics of instance \a i (including its helpers)
+    Search::Statistics statistics(unsigned int i) const;
+  };
+
+  template<template<class> class E, class T>
+  LNSBatch<E,T>::LNSBatch(const Search::Options& o, unsigned int threads, double slice0)
+    : opt(o), pool(threads), slice(slice0), started(0), active(0), helped(0), propagators(NULL) {
+    opt.threads = 1;
+    // The engines run on copies made by the batch
+    opt.clone = false;
+  }
+
+  template<template<class> class E, class T>
+  LNSBatch<E,T>::~LNSBatch(void) {
+    pool.wait();
+    for (unsigned int i = 0; i < instances.size(); i++)
+      delete instances[i];
+    if (propagators != NULL)
+      propagators->print(std::cerr);
+    delete propagators;
+  }
+
+  template<template<class> class E, class T>
+  unsigned int
+  LNSBatch<E,T>::add(T* s, double time) {
+    instances.push_back(new Instance(s, time));
+    return static_cast<unsigned int>(instances.size() - 1);
+  }
+
+  template<template<class> class E, class T>
+  T*
+  LNSBatch<E,T>::model(Instance* i) {
+    if (i->s->status() == SS_FAILED)
+      return NULL;
+    return static_cast<T*>(i->s->clone(false));
+  }
+
+  template<template<class> class E, class T>
+  LNS<E,T>*
+  LNSBatch<E,T>::engine(T* s, const Search::Options& o) {
+    LNS<E,T>* l = new LNS<E,T>(s, o, false);
+    l->meta()->trace(propagators);
+    return l;
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSBatch<E,T>::keep(Instance* i, T* n) {
+    std::lock_guard<std::mutex> lock(i->m);
+    if (i->best == NULL || n->improving(*i->best, true)) {
+      delete i->best;
+      i->best = n;
+    } else
+      delete n;
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSBatch<E,T>::step(Instance* i) {
+    typedef std::chrono::steady_clock Clock;
+    {
+      // A helper has completed the search
+      std::lock_guard<std::mutex> lock(m);
+      if (i->complete) {
+        i->done = true;
+        active--;
+        help();
+        return;
+      }
+    }
+    Clock::time_point start = Clock::now();
+    if (i->engine == NULL) {
+      i->opt = opt;
+      i->opt.stop = &i->stop;
+      LNS<E,T>* engine = NULL;
+      {
+        std::lock_guard<std::mutex> lock(i->m);
+        i->root = model(i);
+        if (i->root != NULL)
+          engine = this->engine(i->root, i->opt);
+      }
+      std::lock_guard<std::mutex> lock(m);
+      started++;
+      if (engine == NULL) {
+        // The model has failed: there is no solution
+        i->complete = true;
+        i->done = true;
+        active--;
+        help();
+        return;
+      }
+      i->engine = engine;
+      help();
+    }
+    double left = i->budget - i->elapsed;
+    i->stop.limit(static_cast<unsigned long int>(std::max(1.0, std::min(slice, left))));
+    i->stop.reset();
+    while (T* n = i->engine->next())
+      keep(i, n);
+    i->elapsed += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(m);
+    // The engine gave up without being stopped: nothing left to search
+    if (!i->stop.stop(i->engine->statistics(), i->opt))
+      i->complete = true;
+    if (i->complete || i->elapsed >= i->budget) {
+      i->done = true;
+      active--;
+      help();
+    } else
+      pool.submit([this, i]() { step(i); });
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSBatch<E,T>::step(Instance* i, Helper* h) {
+    if (h->engine == NULL) {
+      h->opt = opt;
+      h->opt.stop = &h->stop;
+      LNS<E,T>* engine;
+      {
+        // Copying the model updates it (the model has not failed, as the instance has an engine)
+        std::lock_guard<std::mutex> lock(i->m);
+        h->root = model(i);
+        engine = this->engine(h->root, h->opt);
+      }
+      engine->meta()->seed(h->seed);
+      h->engine = engine;
+    }
+    h->stop.limit(static_cast<unsigned long int>(slice));
+    h->stop.reset();
+    while (T* n = h->engine->next())
+      keep(i, n);
+    std::lock_guard<std::mutex> lock(m);
+    // The helper completed the search of the instance, which ends at its next slice
+    if (!h->stop.stop(h->engine->statistics(), h->opt))
+      i->complete = true;
+    if (i->done || i->complete) {
+      active--;
+      help();
+    } else
+      pool.submit([this, i, h]() { step(i, h); });
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSBatch<E,T>::help(void) {
+    if (started < instances.size())
+      return;
+    while (active < pool.size()) {
+      Instance* i = NULL;
+      for (unsigned int k = 0; k < instances.size(); k++) {
+        Instance* c = instances[k];
+        if (!c->done && !c->complete && (i == NULL || c->helpers.size() < i->helpers.size()))
+          i = c;
+      }
+      if (i == NULL)
+        return;
+      Helper* h = new Helper();
+      h->seed = Search::Meta::LNS::lns_options->seed() + ++helped;
+      i->helpers.push_back(h);
+      active++;
+      pool.submit([this, i, h]() { step(i, h); });
+    }
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSBatch<E,T>::run(void) {
+    if (propagators == NULL)
+      propagators = new Search::Meta::PropagatorProfile(Search::Meta::LNS::lns_options->tracePropagators());
+    {
+      std::lock_guard<std::mutex> lock(m);
+      active += instances.size();
+    }
+    for (unsigned int k = 0; k < instances.size(); k++) {
+      Instance* i = instances[k];
+      pool.submit([this, i]() { step(i); });
+    }
+    pool.wait();
+  }
+
+  template<template<class> class E, class T>
+  forceinline unsigned int
+  LNSBatch<E,T>::size(void) const {
+    return static_cast<unsigned int>(instances.size());
+  }
+
+  template<template<class> class E, class T>
+  forceinline const T*
+  LNSBatch<E,T>::solution(unsigned int i) const {
+    return instances[i]->best;
+  }
+
+  template<template<class> class E, class T>
+  forceinline bool
+  LNSBatch<E,T>::complete(unsigned int i) const {
+    return instances[i]->complete;
+  }
+
+  template<template<class> class E, class T>
+  forceinline double
+  LNSBatch<E,T>::time(unsigned int i) const {
+    return instances[i]->elapsed;
+  }
+
+  template<template<class> class E, class T>
+  forceinline Search::Statistics
+  LNSBatch<E,T>::statistics(unsigned int i) const {
+    const Instance* k = instances[i];
+    Search::Statistics s;
+    if (k->engine != NULL)
+      s += k->engine->statistics();
+    for (unsigned int h = 0; h < k->helpers.size(); h++)
+      if (k->helpers[h]->engine != NULL)
+        s += k->helpers[h]->engine->statistics();
+    return s;
+  }
+
+}
+
+#endif
+
+// STATISTICS: search-other
@@ -0,0 +1,65 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_DEADLINE_STOP_HH__
+#define __GECODE_SEARCH_DEADLINE_STOP_HH__
+
+#include <gecode/search.hh>
+#include <atomic>
+#include <chrono>
+
+namespace Gecode { namespace Search {
+
+  /**
+   * \brief Stop object for a wall-clock deadline
+   *
+   * Unlike TimeStop, the clock is not read on every check: a single timer
+   * thread shared by all deadline stops raises a flag once the deadline
+   * has passed, hence checking is a relaxed atomic load. The deadline is
+   * armed by reset(), a limit of zero never expires.
+   */
+  class DeadlineStop : public Stop {
+  public:
+    typedef std::chrono::steady_clock Clock;
+  protected:
+    /// Whether the deadline has passed
+    std::atomic<bool> expired;
+    /// The time limit (in milliseconds)
+    unsigned long int l;
+    /// The armed deadline
+    Clock::time_point deadline;
+    /// Whether a deadline is pending with the timer thread
+    bool armed;
+    friend class DeadlineTimer;
+  public:
+    /// Stop if the time limit \a l (in milliseconds) has been exceeded
+    DeadlineStop(unsigned long int l);
+    /// Withdraw a pending deadline
+    ~DeadlineStop(void);
+    /// Set current limit to \a l (in milliseconds), effective from the next reset()
+    void limit(unsigned long int l);
+    /// Arm the deadline (current time plus limit)
+    void reset(void);
+    /// Return true if the deadline has passed
+    virtual bool stop(const Statistics& s, const Options& o);
+  };
+
+  forceinline bool
+  DeadlineStop::stop(const Statistics&, const Options&) {
+    return expired.load(std::memory_order_relaxed);
+  }
+
+}}
+
+#endif
+
+// STATISTICS: search-other
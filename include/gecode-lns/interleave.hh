@@ -0,0 +1,282 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_LNS_INTERLEAVE_HH__
+#define __GECODE_LNS_INTERLEAVE_HH__
+
+#include "gecode-lns/lns.hh"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Gecode {
+
+  /**
+   * \brief Interleave many LNS trajectories on a few threads
+   *
+   * Every trajectory is an LNS<E,T> meta-engine on its own instance, with
+   * its own seed and, optionally, its own LNS parameters (e.g., another
+   * acceptance criterion). Threads repeatedly take the trajectory with the
+   * highest priority that is not running, let it perform a single step
+   * (an initial solution search or a neighborhood, see
+   * Search::Meta::LNS::step) and put it back: trajectories yield after
+   * every neighborhood instead of owning a thread.
+   *
+   * The priority of a trajectory is the running average of its relative
+   * improvement per step, plus 1/(1 + steps) so that new trajectories
+   * are started first and stagnant ones still get a step now and then.
+   * A trajectory without improvement for \a patience steps is culled
+   * (its engine is deleted, its best solution is kept) unless it is among
+   * the \a keep best ones.
+   *
+   * Search::Meta::LNS::lns_options must be set before the first add().
+   * As the engines move between threads, they have no phase profile or
+   * published metrics of their own, and their neighborhoods are traced
+   * into a single propagator profile of the object.
+   */
+  template<template<class> class E, class T>
+  class LNSInterleaved {
+  protected:
+    /// A trajectory
+    class Trajectory {
+    public:
+      /// The meta-engine (NULL once finished or culled)
+      LNS<E,T>* engine;
+      /// The best solution found so far
+      T* best;
+      /// The cost of best
+      double cost;
+      /// The average relative improvement per step
+      double rate;
+      /// The steps performed, and those since the last improvement
+      unsigned long int steps;
+      unsigned long int idle;
+      /// Whether a thread is performing a step
+      bool running;
+      /// Whether the search has been completed, or given up
+      bool complete;
+      bool culled;
+      /// The statistics of the engine once finished or culled
+      Search::Statistics stats;
+      Trajectory(LNS<E,T>* e)
+        : engine(e), best(NULL), cost(std::numeric_limits<double>::infinity()), rate(0), steps(0), idle(0),
+          running(false), complete(false), culled(false) {}
+      ~Trajectory(void) { delete engine; delete best; }
+      /// The priority of the trajectory
+      double priority(void) const { return rate + 1.0 / (1 + steps); }
+    };
+    /// The trajectories
+    std::vector<Trajectory*> trajectories;
+    /// The options of the engines
+    Search::Options opt;
+    /// The stop object ending the run
+    Search::DeadlineStop stop;
+    /// Steps without improvement before a trajectory is culled
+    unsigned long int patience;
+    /// Number of best trajectories never culled
+    unsigned int keep;
+    /// The propagator profile of all the trajectories (created by the first add())
+    Search::Meta::PropagatorProfile* propagators;
+    /// Protects the trajectories between steps
+    std::mutex m;
+    /// Signalled whenever a step ends
+    std::condition_variable c;
+    /// Return the runnable trajectory with the highest priority (-1 if none, lock must be held)
+    int pick(void) const;
+    /// Whether trajectory \a t is worse than \a keep others (lock must be held)
+    bool cullable(const Trajectory* t) const;
+    /// Retire the engine of trajectory \a t (lock must be held)
+    void retire(Trajectory* t);
+    /// Perform steps until the run is over
+    void work(void);
+  public:
+    /// Initialize with options \a o, culling after \a patience idle steps all but the \a keep best trajectories
+    LNSInterleaved(const Search::Options& o, unsigned long int patience = 1000, unsigned int keep = 1);
+    /// Delete trajectories and solutions
+    ~LNSInterleaved(void);
+    /// Add a trajectory on instance \a s (which is deleted) with seed \a seed and parameters \a p (lns_options if NULL), return its index
+    unsigned int add(T* s, unsigned int seed, LNSBaseOptions* p = NULL);
+    /// Run the trajectories on \a threads threads for \a time milliseconds (zero for no limit)
+    void run(unsigned int threads, double time);
+    /// Return the number of trajectories
+    unsigned int size(void) const;
+    /// Return the best solution of trajectory \a i (NULL if none has been found, owned by the object)
+    const T* solution(unsigned int i) const;
+    /// Whether the search of trajectory \a i has been completed
+    bool complete(unsigned int i) const;
+    /// Whether trajectory \a i has been culled
+    bool culled(unsigned int i) const;
+    /// Return the statistics of trajectory \a i
+    Search::Statistics statistics(unsigned int i) const;
+  };
+
+  template<template<class> class E, class T>
+  LNSInterleaved<E,T>::LNSInterleaved(const Search::Options& o, unsigned long int patience0, unsigned int keep0)
+    : opt(o), stop(0), patience(patience0), keep(keep0), propagators(NULL) {
+    opt.threads = 1;
+    opt.clone = true;
+    opt.stop = &stop;
+  }
+
+  template<template<class> class E, class T>
+  LNSInterleaved<E,T>::~LNSInterleaved(void) {
+    for (unsigned int i = 0; i < trajectories.size(); i++)
+      delete trajectories[i];
+    if (propagators != NULL)
+      propagators->print(std::cerr);
+    delete propagators;
+  }
+
+  template<template<class> class E, class T>
+  unsigned int
+  LNSInterleaved<E,T>::add(T* s, unsigned int seed, LNSBaseOptions* p) {
+    if (propagators == NULL)
+      propagators = new Search::Meta::PropagatorProfile(Search::Meta::LNS::lns_options->tracePropagators());
+    Trajectory* t = new Trajectory(new LNS<E,T>(s, opt, false));
+    delete s;
+    t->engine->meta()->trace(propagators);
+    t->engine->meta()->seed(seed);
+    if (p != NULL)
+      t->engine->meta()->parameters(p);
+    trajectories.push_back(t);
+    return static_cast<unsigned int>(trajectories.size() - 1);
+  }
+
+  template<template<class> class E, class T>
+  int
+  LNSInterleaved<E,T>::pick(void) const {
+    int b = -1;
+    for (unsigned int i = 0; i < trajectories.size(); i++) {
+      const Trajectory* t = trajectories[i];
+      if (t->engine != NULL && !t->running && (b == -1 || t->priority() > trajectories[b]->priority()))
+        b = i;
+    }
+    return b;
+  }
+
+  template<template<class> class E, class T>
+  bool
+  LNSInterleaved<E,T>::cullable(const Trajectory* t) const {
+    unsigned int better = 0;
+    for (unsigned int i = 0; i < trajectories.size(); i++)
+      if (trajectories[i]->cost < t->cost)
+        better++;
+    return better >= keep;
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSInterleaved<E,T>::retire(Trajectory* t) {
+    t->stats = t->engine->statistics();
+    delete t->engine;
+    t->engine = NULL;
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSInterleaved<E,T>::work(void) {
+    std::unique_lock<std::mutex> lock(m);
+    while (!stop.stop(Search::Statistics(), opt)) {
+      int i = pick();
+      if (i == -1) {
+        // Wait for a running trajectory to be put back, unless there is none
+        bool running = false;
+        for (unsigned int k = 0; k < trajectories.size(); k++)
+          running = running || trajectories[k]->running;
+        if (!running)
+          return;
+        c.wait(lock);
+        continue;
+      }
+      Trajectory* t = trajectories[i];
+      t->running = true;
+      lock.unlock();
+
+      Search::Meta::LNS* l = t->engine->meta();
+      T* n = dynamic_cast<T*>(l->step());
+      bool halted = l->done();
+
+      lock.lock();
+      t->running = false;
+      t->steps++;
+      if (n != NULL) {
+        double cost = dynamic_cast<LNSAbstractSpace*>(n)->objective();
+        double gain = t->best == NULL ? 1.0 : (t->cost - cost) / std::max(1.0, std::abs(t->cost));
+        t->rate = 0.9 * t->rate + 0.1 * gain;
+        t->cost = cost;
+        t->idle = 0;
+        delete t->best;
+        t->best = n;
+      } else {
+        t->rate *= 0.9;
+        t->idle++;
+      }
+      if (halted && !stop.stop(Search::Statistics(), opt)) {
+        // Nothing left to search (optimal, within the gap, or infeasible)
+        t->complete = true;
+        retire(t);
+      } else if (t->idle > patience && cullable(t)) {
+        t->culled = true;
+        retire(t);
+      }
+      c.notify_all();
+    }
+  }
+
+  template<template<class> class E, class T>
+  void
+  LNSInterleaved<E,T>::run(unsigned int threads, double time) {
+    stop.limit(static_cast<unsigned long int>(time));
+    stop.reset();
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < std::max(1U, threads); i++)
+      workers.push_back(std::thread(&LNSInterleaved<E,T>::work, this));
+    for (unsigned int i = 0; i < workers.size(); i++)
+      workers[i].join();
+  }
+
+  template<template<class> class E, class T>
+  forceinline unsigned int
+  LNSInterleaved<E,T>::size(void) const {
+    return static_cast<unsigned int>(trajectories.size());
+  }
+
+  template<template<class> class E, class T>
+  forceinline const T*
+  LNSInterleaved<E,T>::solution(unsigned int i) const {
+    return trajectories[i]->best;
+  }
+
+  template<template<class> class E, class T>
+  forceinline bool
+  LNSInterleaved<E,T>::complete(unsigned int i) const {
+    return trajectories[i]->complete;
+  }
+
+  template<template<class> class E, class T>
+  forceinline bool
+  LNSInterleaved<E,T>::culled(unsigned int i) const {
+    return trajectories[i]->culled;
+  }
+
+  template<template<class> class E, class T>
+  forceinline Search::Statistics
+  LNSInterleaved<E,T>::statistics(unsigned int i) const {
+    const Trajectory* t = trajectories[i];
+    return t->engine != NULL ? t->engine->statistics() : t->stats;
+  }
+
+}
+
+#endif
+
+// STATISTICS: search-other
@@ -0,0 +1,95 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_LDS_HH__
+#define __GECODE_SEARCH_LDS_HH__
+
+#include <gecode/search.hh>
+#include <vector>
+
+namespace Gecode { namespace Search {
+
+  /**
+   * \brief Engine for limited discrepancy search
+   *
+   * Taking any alternative but the first one of a choice counts as a
+   * discrepancy. The engine runs probes allowing 0, 1, ... up to the
+   * discrepancy limit \a d_l of the options, each probe only reporting the
+   * solutions that take exactly as many discrepancies (the others have been
+   * reported by earlier probes), and stops as soon as a probe did not cut
+   * any alternative. Nodes are copied rather than recomputed, hence it is
+   * meant for small trees (such as neighborhoods).
+   *
+   * When \a improve is set every solution is required to improve on the
+   * previous one (through Space::constrain), as in branch-and-bound.
+   */
+  class LDS : public Engine {
+  protected:
+    /// A node to be explored
+    class Node {
+    public:
+      /// The space of the node
+      Space* s;
+      /// Discrepancies taken to reach the node
+      unsigned int d;
+      /// The best solution the node is constrained by
+      unsigned long int mark;
+      /// The number of branching nodes above the node
+      unsigned long int level;
+      Node(Space* s0, unsigned int d0, unsigned long int mark0, unsigned long int level0) : s(s0), d(d0), mark(mark0), level(level0) {}
+    };
+    /// The options
+    Options opt;
+    /// The statistics
+    Statistics stats;
+    /// The space to search
+    Space* root;
+    /// The nodes still to be explored in the current probe
+    std::vector<Node> stack;
+    /// The discrepancies of the current probe
+    unsigned int probe;
+    /// Whether the current probe has started
+    bool started;
+    /// Whether the current probe has cut alternatives
+    bool cut;
+    /// Whether solutions must improve on each other
+    bool improve;
+    /// The last solution found (if improving)
+    Space* best;
+    /// The number of solutions found (if improving)
+    unsigned long int generation;
+    /// Whether the engine has been stopped
+    bool has_stopped;
+    /// Whether clones can share data
+    bool shared;
+    /// Delete all nodes
+    void clear(void);
+  public:
+    /// Initialize for space \a s (ownership is taken) with options \a o
+    LDS(Space* s, const Options& o, bool improve);
+    /// Return next solution (NULL, if none exists or search has been stopped)
+    virtual Space* next(void);
+    /// Return statistics
+    virtual Statistics statistics(void) const;
+    /// Check whether engine has been stopped
+    virtual bool stopped(void) const;
+    /// Reset engine to restart at space \a s (ownership is taken)
+    virtual void reset(Space* s);
+    /// Destructor
+    virtual ~LDS(void);
+  };
+
+}}
+
+#endif
+
+// STATISTICS: search-other
@@ -3,9 +3,17 @@
 
 #include <gecode/kernel.hh>
 #include <gecode/search.hh>
+#include <atomic>
+#include <ctime>
+#include <vector>
 
 namespace Gecode {
 
+    namespace Search { namespace Meta { class LNS; } }
+
+    /// The engines available for the initial solution and neighborhood searches
+    enum LNSEngineType { LNS_ENGINE_DEFAULT, LNS_ENGINE_DFS, LNS_ENGINE_BAB, LNS_ENGINE_LDS };
+
     /**
      * \brief Meta-engine performing large neighborhood search
      *
@@ -18,8 +26,8 @@ namespace Gecode {
     template<template<class> class E, class T>
     class LNS : public Search::Base<T> {
     public:
-        /// Initialize engine for space \a s and options \a o
-        LNS(T* s, const Search::Options& o);
+        /// Initialize engine for space \a s and options \a o (without profiles and published metrics unless \a instrumented, see Search::Meta::LNS::trace)
+        LNS(T* s, const Search::Options& o, bool instrumented = true);
         ~LNS(void);
         /// Return next solution (NULL, if non exists or search has been stopped)
         T* next(void);
@@ -28,12 +36,19 @@ namespace Gecode {
         Search::Statistics statistics(void) const;
         /// Check whether engine has been stopped
         bool stopped(void) const;
+        /// Restart the search on space \a s (as the constructor does), reusing the engines
+        void reinit(T* s);
+        /// Return the meta-engine (e.g., for driving it one step at a time)
+        Search::Meta::LNS* meta(void);
         static const bool best = true;
     protected:
         Space* root;
-        E<T>* engine;
-        E<T>* start_engine;
         const Search::Options& opt;
+        /// Create an engine of type \a t for \a s, looking for ever improving solutions if \a improve
+        static Search::Engine* engine(LNSEngineType t, T* s, const Search::Options& o, bool improve);
+        /// Take the actual engine out of \a b (which is deleted)
+        template<class B>
+        static Search::Engine* extract(B* b);
     };
 
     /**
@@ -61,9 +76,13 @@ namespace Gecode {
 
 #include <gecode/search/support.hh>
 #include <gecode/driver.hh>
+#include "gecode-lns/deadline_stop.hh"
+#include "gecode-lns/lds.hh"
 
 namespace Gecode {
     enum LNSConstrainType { LNS_CT_NONE, LNS_CT_LOOSE, LNS_CT_STRICT, LNS_CT_SA };
+    enum LNSRelaxType { LNS_RELAX_MODEL, LNS_RELAX_WORST, LNS_RELAX_LEARNED };
+    enum LNSGuideType { LNS_GUIDE_NONE, LNS_GUIDE_CURRENT, LNS_GUIDE_BEST };
 
     class LNSBaseOptions
     {
@@ -97,6 +116,75 @@ namespace Gecode {
 
         virtual unsigned int SAneighborsAccepted(void) const = 0;
         virtual void SAneighborsAccepted(unsigned int v) = 0;
+
+        virtual double gap(void) const = 0;
+        virtual void gap(double v) = 0;
+
+        virtual unsigned int boundPeriod(void) const = 0;
+        virtual void boundPeriod(unsigned int v) = 0;
+
+        virtual bool profile(void) const = 0;
+        virtual void profile(bool v) = 0;
+
+        virtual bool tracePropagators(void) const = 0;
+        virtual void tracePropagators(bool v) = 0;
+
+        virtual bool polish(void) const = 0;
+        virtual void polish(bool v) = 0;
+
+        virtual unsigned int startRace(void) const = 0;
+        virtual void startRace(unsigned int v) = 0;
+
+        virtual unsigned int eliteSize(void) const = 0;
+        virtual void eliteSize(unsigned int v) = 0;
+
+        virtual double eliteRelink(void) const = 0;
+        virtual void eliteRelink(double v) = 0;
+
+        virtual unsigned int metricsPort(void) const = 0;
+        virtual void metricsPort(unsigned int v) = 0;
+
+        virtual const char* metricsSocket(void) const = 0;
+        virtual void metricsSocket(const char* v) = 0;
+
+        virtual LNSEngineType startEngine(void) const = 0;
+        virtual void startEngine(LNSEngineType v) = 0;
+
+        virtual LNSEngineType engine(void) const = 0;
+        virtual void engine(LNSEngineType v) = 0;
+
+        virtual unsigned int discrepancy(void) const = 0;
+        virtual void discrepancy(unsigned int v) = 0;
+
+        virtual unsigned int decomposition(void) const = 0;
+        virtual void decomposition(unsigned int v) = 0;
+
+        virtual LNSRelaxType relax(void) const = 0;
+        virtual void relax(LNSRelaxType v) = 0;
+
+        virtual double worstDeterminism(void) const = 0;
+        virtual void worstDeterminism(double v) = 0;
+
+        virtual unsigned int seed(void) const = 0;
+        virtual void seed(unsigned int v) = 0;
+
+        virtual unsigned int deterministic(void) const = 0;
+        virtual void deterministic(unsigned int v) = 0;
+
+        virtual unsigned int epoch(void) const = 0;
+        virtual void epoch(unsigned int v) = 0;
+
+        virtual unsigned int neighborNodes(void) const = 0;
+        virtual void neighborNodes(unsigned int v) = 0;
+
+        virtual LNSGuideType guided(void) const = 0;
+        virtual void guided(LNSGuideType v) = 0;
+
+        virtual bool dormantBranching(void) const = 0;
+        virtual void dormantBranching(bool v) = 0;
+
+        virtual bool adaptiveCopy(void) const = 0;
+        virtual void adaptiveCopy(bool v) = 0;
     };
 
     template <class OptionsBase>
@@ -112,12 +200,49 @@ namespace Gecode {
         _max_intensity("-lns_max_intensity", "LNS: the maximum relxation intensity", 5),
         _sa_start_temperature("-lns_sa_start_temperature", "LNS(SA): start temperature", 1.0),
         _sa_cooling_rate("-lns_sa_cooling_rate", "LNS(SA): cooling rate", 0.99),
-        _sa_neighbors_accepted("-lns_sa_neighbors_accepted", "LNS(SA): neighbors accepted per temperature", 100)
+        _sa_neighbors_accepted("-lns_sa_neighbors_accepted", "LNS(SA): neighbors accepted per temperature", 100),
+        _gap("-lns_gap", "LNS: stop when the best solution is within this relative gap from the lower bound", 0.0),
+        _bound_period("-lns_bound_period", "LNS: iterations between lower bound refreshes (0 to disable)", 100),
+        _profile("-lns_profile", "LNS: profile the phases of each iteration with wall-clock and hardware counters", false),
+        _trace_propagators("-lns_trace_propagators", "LNS: profile the executions of each type of propagator in the neighborhoods", false),
+        _polish("-lns_polish", "LNS: polish neighboring solutions with the native local search of the model", false),
+        _start_race("-lns_start_race", "LNS: number of differently branched initial solution searches raced in parallel", 1),
+        _elite_size("-lns_elite_size", "LNS: number of diverse high-quality solutions kept in the elite pool (0 to disable)", 0),
+        _elite_relink("-lns_elite_relink", "LNS: probability of relaxing the variables on which current and an elite solution differ", 0.1),
+        _metrics_port("-lns_metrics_port", "LNS: local TCP port serving live metrics as Prometheus text (0 to disable)", 0),
+        _metrics_socket("-lns_metrics_socket", "LNS: Unix socket serving live metrics as Prometheus text", ""),
+        _start_engine("-lns_start_engine", "LNS: the engine looking for initial solutions (default: the one of the meta-engine, other values: dfs, bab, lds)", LNS_ENGINE_DEFAULT),
+        _engine("-lns_engine", "LNS: the engine exploring neighborhoods (default: the one of the meta-engine, other values: dfs, bab, lds)", LNS_ENGINE_DEFAULT),
+        _discrepancy("-lns_discrepancy", "LNS: the discrepancy limit of the lds engine", 3),
+        _decomposition("-lns_decomposition", "LNS: number of disjoint parts of the current solution improved in parallel per iteration (0 to disable)", 0),
+        _relax("-lns_relax", "LNS: the relaxation (default: model, the one of the model, other values: worst, the variables contributing most to the cost, learned, the variables changing together in improving moves)", LNS_RELAX_MODEL),
+        _worst_determinism("-lns_worst_determinism", "LNS: how greedily the worst relaxation prefers the highest contributions", 3.0),
+        _seed("-lns_seed", "LNS: seed of the random number generator (0 to seed from the clock)", 0),
+        _deterministic("-lns_deterministic", "LNS: number of workers of the deterministic parallel search (0 to disable)", 0),
+        _epoch("-lns_epoch", "LNS: neighborhoods explored by each worker between two incumbent exchanges (deterministic search)", 100),
+        _neighbor_nodes("-lns_neighbor_nodes", "LNS: node limit for each neighborhood search, instead of the time limit (deterministic search, per relaxed variable if -lns_per_variable)", 1000),
+        _guided("-lns_guided", "LNS: the solution whose values are tried first in the neighborhoods (default: none, other values: current, best)", LNS_GUIDE_NONE),
+        _dormant_branching("-lns_dormant_branching", "LNS: post the branchings once in root and only kill the unneeded ones in each copy", false),
+        _adaptive_copy("-lns_adaptive_copy", "LNS: choose the copying and recomputation distances of each neighborhood search from its expected depth", false)
         {
             _constrain_type.add(LNS_CT_NONE, "none");
             _constrain_type.add(LNS_CT_LOOSE, "loose");
             _constrain_type.add(LNS_CT_STRICT, "strict");
             _constrain_type.add(LNS_CT_SA, "sa");
+            _start_engine.add(LNS_ENGINE_DEFAULT, "default");
+            _start_engine.add(LNS_ENGINE_DFS, "dfs");
+            _start_engine.add(LNS_ENGINE_BAB, "bab");
+            _start_engine.add(LNS_ENGINE_LDS, "lds");
+            _engine.add(LNS_ENGINE_DEFAULT, "default");
+            _engine.add(LNS_ENGINE_DFS, "dfs");
+            _engine.add(LNS_ENGINE_BAB, "bab");
+            _engine.add(LNS_ENGINE_LDS, "lds");
+            _relax.add(LNS_RELAX_MODEL, "model");
+            _relax.add(LNS_RELAX_WORST, "worst");
+            _relax.add(LNS_RELAX_LEARNED, "learned");
+            _guided.add(LNS_GUIDE_NONE, "none");
+            _guided.add(LNS_GUIDE_CURRENT, "current");
+            _guided.add(LNS_GUIDE_BEST, "best");
 
             OptionsBase::add(_neighbor_time);
             OptionsBase::add(_per_variable);
@@ -129,6 +254,29 @@ namespace Gecode {
             OptionsBase::add(_sa_start_temperature);
             OptionsBase::add(_sa_cooling_rate);
             OptionsBase::add(_sa_neighbors_accepted);
+            OptionsBase::add(_gap);
+            OptionsBase::add(_bound_period);
+            OptionsBase::add(_profile);
+            OptionsBase::add(_trace_propagators);
+            OptionsBase::add(_polish);
+            OptionsBase::add(_start_race);
+            OptionsBase::add(_elite_size);
+            OptionsBase::add(_elite_relink);
+            OptionsBase::add(_metrics_port);
+            OptionsBase::add(_metrics_socket);
+            OptionsBase::add(_start_engine);
+            OptionsBase::add(_engine);
+            OptionsBase::add(_discrepancy);
+            OptionsBase::add(_decomposition);
+            OptionsBase::add(_relax);
+            OptionsBase::add(_worst_determinism);
+            OptionsBase::add(_seed);
+            OptionsBase::add(_deterministic);
+            OptionsBase::add(_epoch);
+            OptionsBase::add(_neighbor_nodes);
+            OptionsBase::add(_guided);
+            OptionsBase::add(_dormant_branching);
+            OptionsBase::add(_adaptive_copy);
         }
         //    virtual void help(void);
 
@@ -162,11 +310,89 @@ namespace Gecode {
         unsigned int SAneighborsAccepted(void) const { return _sa_neighbors_accepted.value(); }
         void SAneighborsAccepted(unsigned int v) { _sa_neighbors_accepted.value(v); }
 
+        double gap(void) const { return _gap.value(); }
+        void gap(double v) { _gap.value(v); }
+
+        unsigned int boundPeriod(void) const { return _bound_period.value(); }
+        void boundPeriod(unsigned int v) { _bound_period.value(v); }
+
+        bool profile(void) const { return _profile.value(); }
+        void profile(bool v) { _profile.value(v); }
+        bool tracePropagators(void) const { return _trace_propagators.value(); }
+        void tracePropagators(bool v) { _trace_propagators.value(v); }
+
+        bool polish(void) const { return _polish.value(); }
+        void polish(bool v) { _polish.value(v); }
+
+        unsigned int startRace(void) const { return _start_race.value(); }
+        void startRace(unsigned int v) { _start_race.value(v); }
+
+        unsigned int eliteSize(void) const { return _elite_size.value(); }
+        void eliteSize(unsigned int v) { _elite_size.value(v); }
+
+        double eliteRelink(void) const { return _elite_relink.value(); }
+        void eliteRelink(double v) { _elite_relink.value(v); }
+
+        unsigned int metricsPort(void) const { return _metrics_port.value(); }
+        void metricsPort(unsigned int v) { _metrics_port.value(v); }
+
+        const char* metricsSocket(void) const { return _metrics_socket.value(); }
+        void metricsSocket(const char* v) { _metrics_socket.value(v); }
+
+        LNSEngineType startEngine(void) const { return static_cast<LNSEngineType>(_start_engine.value()); }
+        void startEngine(LNSEngineType v) { _start_engine.value(v); }
+
+        LNSEngineType engine(void) const { return static_cast<LNSEngineType>(_engine.value()); }
+        void engine(LNSEngineType v) { _engine.value(v); }
+
+        unsigned int discrepancy(void) const { return _discrepancy.value(); }
+        void discrepancy(unsigned int v) { _discrepancy.value(v); }
+
+        unsigned int decomposition(void) const { return _decomposition.value(); }
+        void decomposition(unsigned int v) { _decomposition.value(v); }
+
+        LNSRelaxType relax(void) const { return static_cast<LNSRelaxType>(_relax.value()); }
+        void relax(LNSRelaxType v) { _relax.value(v); }
+
+        double worstDeterminism(void) const { return _worst_determinism.value(); }
+        void worstDeterminism(double v) { _worst_determinism.value(v); }
+
+        unsigned int seed(void) const { return _seed.value(); }
+        void seed(unsigned int v) { _seed.value(v); }
+
+        unsigned int deterministic(void) const { return _deterministic.value(); }
+        void deterministic(unsigned int v) { _deterministic.value(v); }
+
+        unsigned int epoch(void) const { return _epoch.value(); }
+        void epoch(unsigned int v) { _epoch.value(v); }
+
+        unsigned int neighborNodes(void) const { return _neighbor_nodes.value(); }
+        void neighborNodes(unsigned int v) { _neighbor_nodes.value(v); }
+
+        LNSGuideType guided(void) const { return static_cast<LNSGuideType>(_guided.value()); }
+        void guided(LNSGuideType v) { _guided.value(v); }
+
+        bool dormantBranching(void) const { return _dormant_branching.value(); }
+        void dormantBranching(bool v) { _dormant_branching.value(v); }
+
+        bool adaptiveCopy(void) const { return _adaptive_copy.value(); }
+        void adaptiveCopy(bool v) { _adaptive_copy.value(v); }
+
     protected:
         LNSOptions(const LNSOptions& opt)
         : OptionsBase(opt), _neighbor_time(opt._neighbor_time), _per_variable(opt._per_variable), _stop_at_first_neighbor(opt._stop_at_first_neighbor), _constrain_type(opt._constrain_type), _max_iterations_per_intensity(opt._max_iterations_per_intensity),
         _min_intensity(opt._min_intensity), _max_intensity(opt._max_intensity),
-        _sa_start_temperature(opt._sa_start_temperature), _sa_cooling_rate(opt._sa_cooling_rate), _sa_neighbors_accepted(opt._sa_neighbors_accepted)
+        _sa_start_temperature(opt._sa_start_temperature), _sa_cooling_rate(opt._sa_cooling_rate), _sa_neighbors_accepted(opt._sa_neighbors_accepted),
+        _gap(opt._gap), _bound_period(opt._bound_period), _profile(opt._profile), _trace_propagators(opt._trace_propagators),
+        _polish(opt._polish), _start_race(opt._start_race),
+        _elite_size(opt._elite_size), _elite_relink(opt._elite_relink),
+        _metrics_port(opt._metrics_port), _metrics_socket(opt._metrics_socket),
+        _start_engine(opt._start_engine), _engine(opt._engine), _discrepancy(opt._discrepancy),
+        _decomposition(opt._decomposition),
+        _relax(opt._relax), _worst_determinism(opt._worst_determinism),
+        _seed(opt._seed), _deterministic(opt._deterministic), _epoch(opt._epoch), _neighbor_nodes(opt._neighbor_nodes),
+        _guided(opt._guided),
+        _dormant_branching(opt._dormant_branching), _adaptive_copy(opt._adaptive_copy)
         {}
         // LNS parmeters
         Driver::DoubleOption _neighbor_time;
@@ -180,6 +406,42 @@ namespace Gecode {
         Driver::DoubleOption _sa_start_temperature;
         Driver::DoubleOption _sa_cooling_rate;
         Driver::UnsignedIntOption _sa_neighbors_accepted;
+        // Termination by optimality gap
+        Driver::DoubleOption _gap;
+        Driver::UnsignedIntOption _bound_period;
+        // Profiling
+        Driver::BoolOption _profile;
+        Driver::BoolOption _trace_propagators;
+        // Native local search polishing
+        Driver::BoolOption _polish;
+        // Initial solution race
+        Driver::UnsignedIntOption _start_race;
+        // Elite pool
+        Driver::UnsignedIntOption _elite_size;
+        Driver::DoubleOption _elite_relink;
+        // Live metrics
+        Driver::UnsignedIntOption _metrics_port;
+        Driver::StringValueOption _metrics_socket;
+        // Engines of the initial solution and neighborhood searches
+        Driver::StringOption _start_engine;
+        Driver::StringOption _engine;
+        Driver::UnsignedIntOption _discrepancy;
+        // Decomposition
+        Driver::UnsignedIntOption _decomposition;
+        // Engine-level relaxations
+        Driver::StringOption _relax;
+        Driver::DoubleOption _worst_determinism;
+        // Deterministic parallel search
+        Driver::UnsignedIntOption _seed;
+        Driver::UnsignedIntOption _deterministic;
+        Driver::UnsignedIntOption _epoch;
+        Driver::UnsignedIntOption _neighbor_nodes;
+        // Solution-guided neighborhood search
+        Driver::StringOption _guided;
+        // Branchers posted once in root
+        Driver::BoolOption _dormant_branching;
+        // Copying distances chosen per neighborhood
+        Driver::BoolOption _adaptive_copy;
     };
 
     typedef LNSOptions<SizeOptions> LNSSizeOptions;
@@ -189,21 +451,92 @@ namespace Gecode {
 namespace Gecode { namespace Search {
 
     /// This class implements a combined stop criterion for LNS based meta-engines
-    /// the underlying engine is handled through a TimeStop, while the lns_stop is passed
-    /// (possibly) from the script controlling the meta-engine.
+    /// the underlying engine is handled through a DeadlineStop, while the lns_stop is passed
+    /// (possibly) from the script controlling the meta-engine. The latter may read the clock,
+    /// hence it is only polled every few checks.
     class LNSMetaStop : public Stop {
     protected:
         Stop* lns_stop;
-        Stop* e_stop;
+        DeadlineStop* e_stop;
+        /// Checks left before polling lns_stop again (the workers of a parallel engine check concurrently)
+        std::atomic<int> poll;
+        /// The node limit (zero for none) and the checks since the last reset()
+        unsigned long int nodes;
+        std::atomic<unsigned long int> checks;
     public:
-        LNSMetaStop(Stop* lns_stop0, TimeStop* e_stop0) : lns_stop(lns_stop0), e_stop(e_stop0) {}
+        /// Checks between two polls of the meta-engine stop criterion
+        static const int poll_interval = 64;
+        LNSMetaStop(Stop* lns_stop0, DeadlineStop* e_stop0) : lns_stop(lns_stop0), e_stop(e_stop0), poll(0), nodes(0), checks(0) {}
+        /// Set the time limit to \a l (in milliseconds) and the node limit to \a n (zero for none), effective from the next reset()
+        void limit(unsigned long int l, unsigned long int n = 0) {
+            if (e_stop != NULL)
+                e_stop->limit(l);
+            nodes = n;
+        }
+        /// Start counting nodes and arm the deadline
+        void reset(void) {
+            checks.store(0);
+            if (e_stop != NULL)
+                e_stop->reset();
+        }
         /// The stop method verifies a combined stopping condition
         /// (i.e., whether either the meta-engine or the engine stop criterion is satisfied)
         virtual bool stop(const Statistics& s, const Options& o) {
-            return (e_stop != NULL && e_stop->stop(s,o)) || (lns_stop != NULL && lns_stop->stop(s,o));
+            // The engines check once per node, counting the checks does not depend on the statistics of the engine
+            if (nodes > 0 && checks.fetch_add(1, std::memory_order_relaxed) >= nodes)
+                return true;
+            if (e_stop != NULL && e_stop->stop(s,o))
+                return true;
+            if (lns_stop == NULL || poll.fetch_sub(1, std::memory_order_relaxed) > 0)
+                return false;
+            poll.store(poll_interval, std::memory_order_relaxed);
+            return lns_stop->stop(s,o);
+        }
+    };
+
+    /// This class implements the stop criterion of the initial solution searches raced in parallel:
+    /// they all stop as soon as one of them has been declared the winner, or when the lns_stop does.
+    class LNSRaceStop : public Stop {
+    protected:
+        Stop* lns_stop;
+        std::atomic<bool> over;
+    public:
+        LNSRaceStop(Stop* lns_stop0) : lns_stop(lns_stop0), over(false) {}
+        /// Start a new race
+        void reset(void) { over.store(false); }
+        /// End the race, returns whether the caller is the first to end it
+        bool finish(void) { return !over.exchange(true); }
+        virtual bool stop(const Statistics& s, const Options& o) {
+            return over.load(std::memory_order_relaxed) || (lns_stop != NULL && lns_stop->stop(s,o));
         }
     };
 
+    /// The engines improving the parts of a decomposition in parallel, each with its own time limit
+    class LNSParts {
+    public:
+        std::vector<Engine*> engines;
+        std::vector<DeadlineStop*> deadlines;
+        std::vector<LNSMetaStop*> stops;
+        ~LNSParts(void) {
+            for (unsigned int i = 0; i < engines.size(); i++) {
+                delete engines[i];
+                delete stops[i];
+                delete deadlines[i];
+            }
+        }
+    };
+
+    /// The workers of a deterministic parallel search, each with its own copy of root and its own statistics
+    class LNSWorkers {
+    public:
+        std::vector<Meta::LNS*> engines;
+        std::vector<Space*> roots;
+        std::vector<DeadlineStop*> deadlines;
+        std::vector<LNSMetaStop*> stops;
+        std::vector<Statistics> stats;
+        ~LNSWorkers(void);
+    };
+
     /// Waiting for a more integrated (and not intrusive) solution, this class is abused
     /// for passing specific parameters to the LNS engine
     class LNSParameters : public LNSInstanceOptions {
@@ -220,22 +553,28 @@ namespace Gecode {
     namespace Search {
 
         GECODE_SEARCH_EXPORT Engine* lns(Space* s, size_t sz,
-                                         TimeStop* e_stop,
+                                         LNSMetaStop* e_stop,
                                          Engine* se,
                                          Engine* e,
+                                         const std::vector<Engine*>& copies,
+                                         const std::vector<Engine*>& racers,
+                                         LNSRaceStop* race_stop,
+                                         LNSParts* parts,
+                                         LNSWorkers* workers,
                                          Search::Statistics& st,
-                                         const Options& o);
+                                         const Options& o,
+                                         bool instrumented = true);
     }
 
     template<template<class> class E, class T>
     forceinline
-    LNS<E,T>::LNS(T* s, const Search::Options& m_opt) : opt(m_opt) {
+    LNS<E,T>::LNS(T* s, const Search::Options& m_opt, bool instrumented) : opt(m_opt) {
         Search::Options e_opt;
         e_opt.clone = true;
         e_opt.threads = m_opt.threads;
         e_opt.c_d = m_opt.c_d;
         e_opt.a_d = m_opt.a_d;
-        Search::TimeStop* ts = new Search::TimeStop(0);
+        Search::DeadlineStop* ts = new Search::DeadlineStop(0);
         Search::LNSMetaStop* ms = new Search::LNSMetaStop(m_opt.stop, ts);
         e_opt.stop = ms;
         if (m_opt.clone) {
@@ -249,15 +588,101 @@ namespace Gecode {
         } else {
             root = s;
         }
-        Search::Options& s_opt(const_cast<Search::Options&>(m_opt));
+        Search::Options s_opt(m_opt);
         s_opt.clone = true;
-        engine = new E<T>(dynamic_cast<T*>(root),e_opt);
-        Search::Engine* ee = engine->e; // FIXME: now this class has to be friend of BaseEngine to allow it
-        engine->e = NULL;
-        start_engine = new E<T>(dynamic_cast<T*>(root),s_opt);
-        Search::Engine* se = start_engine->e;
-        start_engine->e = NULL;
-        this->e = Search::lns(root,sizeof(T),ts,se,ee,stats,m_opt);
+        LNSBaseOptions* lns_options = Search::Meta::LNS::lns_options;
+        e_opt.d_l = s_opt.d_l = lns_options->discrepancy();
+        Search::Engine* ee = engine(lns_options->engine(), dynamic_cast<T*>(root), e_opt, true);
+        // Neighborhood engines copying at every node (for trees not deeper than c_d), at the given distances (up to 16 times c_d), and four times as far (for deeper trees)
+        std::vector<Search::Engine*> copies;
+        if (lns_options->adaptiveCopy()) {
+            Search::Options c_opt(e_opt);
+            c_opt.c_d = 1;
+            c_opt.a_d = 1;
+            copies.push_back(engine(lns_options->engine(), dynamic_cast<T*>(root), c_opt, true));
+            copies.push_back(ee);
+            c_opt.c_d = 4 * e_opt.c_d;
+            c_opt.a_d = 4 * e_opt.a_d;
+            copies.push_back(engine(lns_options->engine(), dynamic_cast<T*>(root), c_opt, true));
+        }
+        // Additional initial solution searches, raced against each other
+        std::vector<Search::Engine*> racers;
+        Search::LNSRaceStop* rs = NULL;
+        unsigned int race = lns_options->startRace();
+        if (race > 1) {
+            rs = new Search::LNSRaceStop(m_opt.stop);
+            Search::Options r_opt(s_opt);
+            r_opt.threads = 1;
+            r_opt.stop = rs;
+            for (unsigned int i = 0; i < race; i++)
+                racers.push_back(engine(lns_options->startEngine(), dynamic_cast<T*>(root), r_opt, false));
+        }
+        // Engines for the parts of a decomposition, running in parallel
+        Search::LNSParts* parts = NULL;
+        if (lns_options->decomposition() > 0) {
+            parts = new Search::LNSParts();
+            for (unsigned int i = 0; i < lns_options->decomposition(); i++) {
+                Search::Options p_opt(e_opt);
+                p_opt.threads = 1;
+                parts->deadlines.push_back(new Search::DeadlineStop(0));
+                parts->stops.push_back(new Search::LNSMetaStop(m_opt.stop, parts->deadlines.back()));
+                p_opt.stop = parts->stops.back();
+                parts->engines.push_back(engine(lns_options->engine(), dynamic_cast<T*>(root), p_opt, true));
+            }
+        }
+        // Workers of a deterministic parallel search, each on its own copy of root with its own seed, without
+        // instrumentation of their own as they iterate on the threads of the epochs (see Search::Meta::LNS::trace)
+        Search::LNSWorkers* workers = NULL;
+        if (lns_options->deterministic() > 0 && root != NULL) {
+            unsigned int seed = lns_options->seed() != 0 ? lns_options->seed() : static_cast<unsigned int>(std::time(NULL));
+            workers = new Search::LNSWorkers();
+            workers->stats.resize(lns_options->deterministic());
+            for (unsigned int i = 0; i < lns_options->deterministic(); i++) {
+                Space* w = root->clone(false);
+                // The overall stop is only checked between epochs, by the coordinator
+                Search::Options w_opt(s_opt);
+                w_opt.threads = 1;
+                w_opt.stop = NULL;
+                workers->deadlines.push_back(new Search::DeadlineStop(0));
+                workers->stops.push_back(new Search::LNSMetaStop(NULL, workers->deadlines.back()));
+                Search::Options we_opt(w_opt);
+                we_opt.stop = workers->stops.back();
+                Search::Engine* w_e = engine(lns_options->engine(), dynamic_cast<T*>(w), we_opt, true);
+                Search::Engine* w_se = engine(lns_options->startEngine(), dynamic_cast<T*>(w), w_opt, false);
+                Search::Meta::LNS* l = static_cast<Search::Meta::LNS*>(Search::lns(w,sizeof(T),workers->stops.back(),w_se,w_e,std::vector<Search::Engine*>(),std::vector<Search::Engine*>(),NULL,NULL,NULL,workers->stats[i],w_opt,false));
+                l->seed(seed + i);
+                workers->roots.push_back(w);
+                workers->engines.push_back(l);
+            }
+        }
+        Search::Engine* se = engine(lns_options->startEngine(), dynamic_cast<T*>(root), s_opt, false);
+        this->e = Search::lns(root,sizeof(T),ms,se,ee,copies,racers,rs,parts,workers,stats,s_opt,instrumented);
+    }
+
+    template<template<class> class E, class T>
+    template<class B>
+    forceinline Search::Engine*
+    LNS<E,T>::extract(B* b) {
+        Search::Engine* e = b->e; // FIXME: now this class has to be friend of BaseEngine to allow it
+        b->e = NULL;
+        delete b;
+        return e;
+    }
+
+    template<template<class> class E, class T>
+    Search::Engine*
+    LNS<E,T>::engine(LNSEngineType t, T* s, const Search::Options& o, bool improve) {
+        switch (t) {
+            case LNS_ENGINE_DFS:
+                return extract(new DFS<T>(s,o));
+            case LNS_ENGINE_BAB:
+                return extract(new BAB<T>(s,o));
+            case LNS_ENGINE_LDS:
+                return new Search::LDS(s,o,improve);
+            case LNS_ENGINE_DEFAULT:
+            default:
+                return extract(new E<T>(s,o));
+        }
     }
 
     template<template<class> class E, class T>
@@ -279,12 +704,36 @@ namespace Gecode {
     }
 
 
+    template<template<class> class E, class T>
+    void
+    LNS<E,T>::reinit(T* s) {
+        Space* old = root;
+        if (opt.clone) {
+            if (s->status(stats) == SS_FAILED) {
+                stats.fail++;
+                root = NULL;
+            } else {
+                root = s->clone();
+            }
+        } else {
+            root = s;
+        }
+        static_cast<Search::Meta::LNS*>(this->e)->reinit(root);
+        if (opt.clone)
+            delete old;
+    }
+
+    template<template<class> class E, class T>
+    forceinline Search::Meta::LNS*
+    LNS<E,T>::meta(void) {
+        return static_cast<Search::Meta::LNS*>(this->e);
+    }
+
     template<template<class> class E, class T>
     forceinline
     LNS<E,T>::~LNS(void) {
         if (opt.clone)
             delete root;
-        //delete engine; delete start_engine;
     }
 
 
@@ -3,27 +3,177 @@
 
 #include <gecode/kernel.hh>
 #include <gecode/driver.hh>
+#include "gecode-lns/relax.hh"
+#include <limits>
+#include <vector>
 
 using namespace Gecode;
 
 class LNSAbstractSpace
 {
+protected:
+  /** The values tried first by guided_branch() (an uninitialized handle unless lns_guided) */
+  SharedArray<int> lns_guide;
+  bool lns_guided;
+  /** The groups of the branchers posted once by dormant_branching(), and whether they have been */
+  BrancherGroup lns_start_branchers;
+  BrancherGroup lns_neighborhood_branchers;
+  bool lns_dormant;
+
 public:
 
+  LNSAbstractSpace(void)
+    : lns_guided(false), lns_start_branchers(BrancherGroup::def), lns_neighborhood_branchers(BrancherGroup::def), lns_dormant(false) {}
+
+  /** Copies keep the guide (updated by the copy constructor of the space) and the dormant branchers (if any) */
+  LNSAbstractSpace(const LNSAbstractSpace& s)
+    : lns_guided(s.lns_guided), lns_start_branchers(s.lns_start_branchers), lns_neighborhood_branchers(s.lns_neighborhood_branchers), lns_dormant(s.lns_dormant) {}
+
+  /** Set the values (of the relaxable variables, as returned by assignment()) tried first by guided_branch() */
+  void guide(const std::vector<int>& a)
+  {
+    if (a.empty())
+      return;
+    lns_guided = true;
+    lns_guide.init(a.size());
+    for (unsigned int i = 0; i < a.size(); i++)
+      lns_guide[i] = a[i];
+  }
+
+  /** Returns the values tried first by guided_branch() (only if guided()) */
+  const SharedArray<int>& guide(void) const
+  {
+    return lns_guide;
+  }
+
+  /** Whether a guide has been set */
+  bool guided(void) const
+  {
+    return lns_guided;
+  }
+
+  /** Whether the branchers of both searches have been posted by dormant_branching() */
+  bool dormant(void) const
+  {
+    return lns_dormant;
+  }
+
+  /**
+   Post (in this root space) the branchings of the first initial solution search and of the neighborhood
+   search (guided if \a guided), each in its own group, so that copies only have to kill the group they
+   do not need. Returns whether it is supported (by default it is not).
+   */
+  virtual bool dormant_branching(bool guided)
+  {
+    return false;
+  }
+
+  /** Kill the dormant branchers of the initial solution search */
+  virtual void kill_start_branching(void)
+  {
+  }
+
+  /** Kill the dormant branchers of the neighborhood search */
+  virtual void kill_neighborhood_branching(void)
+  {
+  }
+
+
   /** Post a random branching, e.g. good for finding a random initial solution in LNS */
   virtual void initial_solution_branching(unsigned long int restart) = 0;
 
   /** Post a branching for LNS iteration step, the idea is that it should likely find a good solution  */
   virtual void neighborhood_branching() = 0;
 
-  /** Method to generate a relaxed solution (i.e., a neighbor) from the current one (this) */
-  virtual unsigned int relax(Space* neighbor, unsigned int free) = 0;
+  /**
+   Post a branching for LNS iteration step trying the values of guide() first (see guided_branch()),
+   by default the guide is ignored
+   */
+  virtual void guided_branching()
+  {
+    neighborhood_branching();
+  }
+
+  /**
+   Method to generate a relaxed solution (i.e., a neighbor) from the current one (this), all random
+   choices should be drawn from \a r (see relax.hh for ready-made relaxations)
+   */
+  virtual unsigned int relax(Space* neighbor, unsigned int free, LNSRandom& r) = 0;
+
+  /**
+   Choose the variables that the next call to relax() will free and return a lower bound on the
+   cost of any solution of the resulting neighborhood, so that hopeless neighborhoods can be skipped
+   before being built. By default no estimate is available (and relax() chooses by itself).
+   */
+  virtual double neighborhood_bound(unsigned int free, LNSRandom& r)
+  {
+    return -std::numeric_limits<double>::infinity();
+  }
+
+  /**
+   Forget the variables chosen by neighborhood_bound(), as the neighborhood has been skipped and the
+   next call to relax() must choose by itself
+   */
+  virtual void neighborhood_skipped()
+  {
+  }
 
   /* Returns whether the current space is improving w.r.t. s */
   virtual bool improving(const Space& s, bool strict = true) = 0;
 
   /* Constrain current solution cost to improve over the one passed as parameter plus/minus a delta */
   virtual void constrain(const Space& s, bool strict, double delta) = 0;
+
+  /** Returns the cost of the current solution */
+  virtual double objective(void) const = 0;
+
+  /**
+   Store the values of the relaxable variables of the current (solved) space into \a a, so that the
+   engine can compare solutions and relax them by itself (by default the assignment is not exposed)
+   */
+  virtual void assignment(std::vector<int>& a) const
+  {
+    a.clear();
+  }
+
+  /**
+   Store into \a c the contribution of each relaxable variable of the current (solved) space to its
+   cost, so that the engine can relax the most expensive parts first (by default none is known)
+   */
+  virtual void contributions(std::vector<double>& c) const
+  {
+    c.clear();
+  }
+
+  /** Fix each relaxable variable \a i of the current space such that \a keep[i] holds to \a a[i] */
+  virtual void fix(const std::vector<int>& a, const std::vector<bool>& keep)
+  {
+  }
+
+  /**
+   Store into \a r the relaxable variables interacting with relaxable variable \a i, used to decompose
+   the current solution into parts that can be improved independently (by default there are none)
+   */
+  virtual void related(unsigned int i, std::vector<unsigned int>& r) const
+  {
+    r.clear();
+  }
+
+  /**
+   Improve the current (solved) space by a native local search and impose the resulting
+   assignment of all decision variables on \a s (a fresh copy of the root space).
+   Returns whether an improved assignment has been imposed (by default no polishing is done).
+   */
+  virtual bool polish(Space* s)
+  {
+    return false;
+  }
+
+  /** Returns a lower bound on the cost of any solution of the current space (by default none is known) */
+  virtual double lower_bound(void) const
+  {
+    return -std::numeric_limits<double>::infinity();
+  }
 };
 
 template <class ScriptType>
@@ -48,11 +198,81 @@ public:
       rel(*this, this->cost() <= _s.cost().val() + delta);
   }
 
+  virtual double objective(void) const
+  {
+    return this->cost().val();
+  }
+
+  /** Both branchings are posted in the default group first, then moved to their own group */
+  virtual bool dormant_branching(bool guided)
+  {
+    this->lns_start_branchers = BrancherGroup();
+    this->lns_neighborhood_branchers = BrancherGroup();
+    this->initial_solution_branching(0);
+    this->lns_start_branchers.move(*this, BrancherGroup::def);
+    if (guided)
+      this->guided_branching();
+    else
+      this->neighborhood_branching();
+    this->lns_neighborhood_branchers.move(*this, BrancherGroup::def);
+    this->lns_dormant = true;
+    return true;
+  }
+
+  virtual void kill_start_branching(void)
+  {
+    this->lns_start_branchers.kill(*this);
+  }
+
+  virtual void kill_neighborhood_branching(void)
+  {
+    this->lns_neighborhood_branchers.kill(*this);
+  }
+
+  /** The default lower bound is the propagation bound on the cost variable */
+  virtual double lower_bound(void) const
+  {
+    return this->cost().min();
+  }
+
 protected:
   LNSScript() : ScriptType(nullptr) {}
   template<class O>
   LNSScript(const O& opt) : ScriptType(opt) {}
-  LNSScript(bool share, LNSScript& s) : ScriptType(share,s) {}
+  LNSScript(bool share, LNSScript& s) : LNSAbstractSpace(s), ScriptType(share,s)
+  {
+    if (this->lns_guided)
+      this->lns_guide.update(*this, share, s.lns_guide);
+  }
 };
 
+/** Value of guided_branch(): the guide value of the variable */
+inline int
+lns_guide_value(const Space& home, IntVar, int i)
+{
+  return dynamic_cast<const LNSAbstractSpace&>(home).guide()[i];
+}
+
+/** Filter of guided_branch(): the variables whose guide value is still in their domain */
+inline bool
+lns_guide_filter(const Space& home, IntVar x, int i)
+{
+  const LNSAbstractSpace& s = dynamic_cast<const LNSAbstractSpace&>(home);
+  if (!s.guided())
+    return false;
+  const SharedArray<int>& g = s.guide();
+  return i < g.size() && x.in(g[i]);
+}
+
+/**
+ Branch on \a x (whose i-th variable is the i-th relaxable variable) trying the guide value of each
+ variable first, in the order given by \a vars. Variables whose guide value has been pruned are skipped,
+ so that the branchings posted next (e.g., the model heuristic) take care of them.
+ */
+inline void
+guided_branch(Home home, const IntVarArgs& x, IntVarBranch vars = INT_VAR_NONE())
+{
+  branch(home, x, vars, INT_VAL(&lns_guide_value), &lns_guide_filter);
+}
+
 #endif
@@ -12,12 +12,19 @@
 
 
 
+// lns.hh includes this file once its declarations are complete, and its templates need the engine
+#include "gecode-lns/lns.hh"
+
 #ifndef __GECODE_SEARCH_META_LNS_HH__
 #define __GECODE_SEARCH_META_LNS_HH__
 
 #include <gecode/search.hh>
-
-#include "gecode-lns/lns.hh"
+#include "gecode-lns/lns_space.hh"
+#include "gecode-lns/metrics.hh"
+#include "gecode-lns/perf_counters.hh"
+#include "gecode-lns/propagator_profile.hh"
+#include "gecode-lns/relatedness.hh"
+#include <limits>
 
 namespace Gecode { namespace Search { namespace Meta {
 
@@ -27,6 +34,20 @@ namespace Gecode { namespace Search { namespace Meta {
     /// The actual engine(s)
     Engine* se;
     Engine* e;
+    /// The neighborhood engines with increasing copying distances (if chosen per neighborhood, e is one of them)
+    std::vector<Engine*> copies;
+    /// The average depth of the neighborhood trees per free variable
+    double depth;
+    /// Whether the neighborhood engines report the depth of their last search (they clear it on reset)
+    bool depth_reported;
+    /// The initial solution searches raced in parallel (if any)
+    std::vector<Engine*> racers;
+    /// The stop control object ending a race
+    LNSRaceStop* race_stop;
+    /// The engines improving the parts of a decomposition (if any)
+    LNSParts* parts;
+    /// The workers of a deterministic parallel search (if any)
+    LNSWorkers* workers;
     /// The root space to create new partial solutions from scratch
     Space* root;
     /// The best solution that far
@@ -34,13 +55,15 @@ namespace Gecode { namespace Search { namespace Meta {
     /// The current solution
     Space* current;
     /// The stop control object for the sub-engine
-    Stop* e_stop;
+    LNSMetaStop* e_stop;
     /// The stop control object for the overall LNS
     Stop* m_stop;
     /// The statistics
     Search::Statistics& stats;
     /// The options
-    const Options& opt;
+    Options opt;
+    /// The LNS parameters of this engine (lns_options, unless set otherwise)
+    LNSBaseOptions* params;
     /// The number of times stop has reached
     unsigned long int restart;
     /// The number of idle iterations performed (for detecting stagnation)
@@ -51,21 +74,104 @@ namespace Gecode { namespace Search { namespace Meta {
     bool shared;
     /// Random numbers generator
     Rnd r;
+    /// Random numbers generator and subset sampler for the relaxations
+    LNSRandom relax_rnd;
     /// Current temperature for SA
     double temperature;
     /// Neighbors accepted at current temperature
     unsigned long int neighbors_accepted;
+    /// The best known lower bound on the cost
+    double bound;
+    /// The number of neighborhoods explored (for refreshing the bound)
+    unsigned long int iterations;
+    /// Whether the last step could not continue the search (stopped, infeasible, or optimal)
+    bool halted;
+    /// Whether the initial solution search has been stopped before finding a solution (and is to be resumed)
+    bool starting;
+    /// Per-phase profile of the iterations (if requested)
+    PerfCounters profile;
+    /// Per-propagator profile of the neighborhoods (if requested)
+    PropagatorProfile propagators;
+    /// Live counters (published if requested)
+    LNSMetrics metrics;
+    /// The profile the neighborhoods are traced into (propagators, unless the engine is stepped with others)
+    PropagatorProfile* tracer;
+    /// The elite pool of diverse high-quality solutions
+    std::vector<Space*> elite;
+    /// The assignments of the elite solutions
+    std::vector<std::vector<int> > elite_values;
+    /// Scratch assignment and fixing mask for engine-level relaxations
+    std::vector<int> values;
+    std::vector<bool> keep;
+    std::vector<double> contributions;
+    /// Scratch clusters of a decomposition, the cluster of each variable (or free/blocked) and related variables
+    std::vector<std::vector<unsigned int> > clusters;
+    std::vector<int> cluster_of;
+    std::vector<unsigned int> related;
+    /// The relatedness of the variables learned from improving moves, and the scratch assignment of a move
+    LNSRelatedness relatedness;
+    std::vector<int> moved;
+
+    /// Tighten the lower bound by propagating the best cost bound on a copy of root
+    void refresh_bound(void);
+    /// Whether the best solution is within the requested gap from the lower bound
+    bool gap_closed(void) const;
+    /// Perform one step (an initial solution search or a neighborhood) from a root that has not failed, return the new best solution (if found)
+    Space* iterate(void);
+    /// Return the polished version of solution \a n (or \a n itself if it cannot be improved)
+    Space* polished(Space* n);
+    /// Offer solution \a s to the elite pool
+    void remember(Space* s);
+    /// Choose an elite solution differing from current to relink with (-1 if none)
+    int relink_guide(void);
+    /// Fix into \a neighbor the variables on which current and elite solution \a g agree, return how many are free
+    unsigned int relink(Space* neighbor, unsigned int g);
+    /// Relax into \a neighbor the variables of current contributing most to its cost, return how many are free
+    unsigned int relax_worst(Space* neighbor);
+    /// Relax into \a neighbor the variables of current most related to each other by the improving moves, return how many are free
+    unsigned int relax_learned(Space* neighbor);
+    /// Learn from the improving move from current to \a n
+    void learn(Space* n);
+    /// Improve disjoint parts of current in parallel, return the merged improvement (NULL if none)
+    Space* decompose(void);
+    /// Return a solution of root with assignment \a a (NULL if it fails or none is found within the neighborhood limit)
+    Space* complete(const std::vector<int>& a);
+    /// Run the workers epoch after epoch until one of them improves on best, return the improvement
+    Space* epochs(void);
+    /// Choose the neighborhood engine for a tree over \a free variables
+    void choose_copies(unsigned int free);
+    /// Post the dormant branchers in root (if requested)
+    void prepost(void);
+    /// Activate in \a s (a copy of root) the branching of the initial solution search \a variant
+    void start_branching(Space* s, unsigned long int variant);
+    /// Activate in \a s (a copy of root) the branching of the neighborhood search
+    void neighborhood_branching(Space* s);
+    /// Race the initial solution searches from \a s (which is deleted), or resume the stopped race if \a s is NULL, return the winning solution
+    Space* race(Space* s);
 
     /// Empty no-goods (copied from RBS)
     GECODE_SEARCH_EXPORT
     static NoGoods eng;
 
   public:
-    /// Constructor
-    LNS(Space*, size_t, TimeStop* e_stop0,
-        Engine* se0, Engine* e0, Search::Statistics& stats0, const Options& opt0);
+    /// Constructor (without profiles and published metrics of its own unless \a instrumented)
+    LNS(Space*, size_t, LNSMetaStop* e_stop0,
+        Engine* se0, Engine* e0, const std::vector<Engine*>& copies0, const std::vector<Engine*>& racers0, LNSRaceStop* race_stop0,
+        LNSParts* parts0, LNSWorkers* workers0, Search::Statistics& stats0, const Options& opt0, bool instrumented = true);
     /// Return next solution (NULL, if none exists or search has been stopped)
     virtual Space* next(void);
+    /// Perform one step (an initial solution search, a neighborhood, or the epochs up to the next improvement of the workers), return the new best solution (if found)
+    Space* step(void);
+    /// Whether the last step could not continue the search (stopped, infeasible, or optimal)
+    bool done(void) const { return halted; }
+    /// Seed the random number generator with \a s
+    void seed(unsigned int s) { r.seed(s); }
+    /// Use the LNS parameters \a p (e.g., another acceptance criterion) instead of lns_options
+    void parameters(LNSBaseOptions* p) { params = p; }
+    /// Trace the neighborhoods (also those of the workers) into \a p, e.g. the profile shared by the engines stepped on a pool
+    void trace(PropagatorProfile* p);
+    /// Forget the search so far and start over from root \a s (NULL if it is failed), keeping the engines
+    void reinit(Space* s);
     /// Return statistics
     virtual Search::Statistics statistics(void) const;
     /// Check whether engine has been stopped
@@ -83,12 +189,33 @@ namespace Gecode { namespace Search { namespace Meta {
   };
 
   forceinline
-  LNS::LNS(Space* s, size_t, TimeStop* e_stop0,
-           Engine* se0, Engine* e0, Search::Statistics& stats0, const Options& opt0)
-    : se(se0), e(e0), root(s), best(0), current(0), e_stop(e_stop0), m_stop(opt0.stop), stats(stats0), opt(opt0), restart(0), idle_iterations(0),
-  shared(opt.threads == 1), temperature(1.0) {
+  LNS::LNS(Space* s, size_t, LNSMetaStop* e_stop0,
+           Engine* se0, Engine* e0, const std::vector<Engine*>& copies0, const std::vector<Engine*>& racers0, LNSRaceStop* race_stop0,
+           LNSParts* parts0, LNSWorkers* workers0, Search::Statistics& stats0, const Options& opt0, bool instrumented)
+    : se(se0), e(e0), copies(copies0), depth(1.0), depth_reported(true), racers(racers0), race_stop(race_stop0), parts(parts0), workers(workers0), root(s), best(0), current(0), e_stop(e_stop0), m_stop(opt0.stop), stats(stats0), opt(opt0), params(lns_options), restart(0), idle_iterations(0),
+  shared(opt.threads == 1), relax_rnd(r), temperature(1.0), bound(-std::numeric_limits<double>::infinity()), iterations(0), halted(false), starting(false),
+  profile(instrumented && lns_options->profile()), propagators(instrumented && lns_options->tracePropagators()),
+  metrics(instrumented ? lns_options->metricsPort() : 0, instrumented ? lns_options->metricsSocket() : NULL), tracer(&propagators) {
+
+    if (params->seed() != 0)
+      r.seed(params->seed());
+    else
+      r.time();
+    if (root != NULL)
+      bound = dynamic_cast<LNSAbstractSpace*>(root)->lower_bound();
+    prepost();
+    // The workers are built without instrumentation, and profiled by this engine
+    if (workers != NULL)
+      for (unsigned int i = 0; i < workers->engines.size(); i++)
+        workers->engines[i]->trace(tracer);
+  }
 
-    r.time();
+  forceinline void
+  LNS::trace(PropagatorProfile* p) {
+    tracer = p;
+    if (workers != NULL)
+      for (unsigned int i = 0; i < workers->engines.size(); i++)
+        workers->engines[i]->trace(p);
   }
 
 }}}
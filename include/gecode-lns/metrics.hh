@@ -0,0 +1,136 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_META_METRICS_HH__
+#define __GECODE_SEARCH_META_METRICS_HH__
+
+#include <gecode/search.hh>
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+namespace Gecode { namespace Search { namespace Meta {
+
+  /**
+   * \brief Live counters of a running LNS engine
+   *
+   * The counters are written by the engine with relaxed atomic stores and
+   * can be read at any time, from any thread, by snapshot() without
+   * locking. Published metrics are served, together with those of all
+   * other published engines of the process, as Prometheus text by a
+   * single exporter thread listening on a local TCP port and/or Unix
+   * socket.
+   */
+  class LNSMetrics {
+  public:
+    typedef std::chrono::steady_clock Clock;
+    /// Seconds over which the rate of iterations is measured
+    static const unsigned int window = 10;
+    /// A copy of the counters
+    struct Snapshot {
+      /// The identifier of the engine within the process
+      unsigned long int id;
+      /// Seconds since the engine has been created
+      double elapsed;
+      /// Neighborhoods explored
+      unsigned long int iterations;
+      /// Neighborhoods explored per second over the last window seconds
+      double iterations_per_second;
+      /// Current intensity
+      unsigned int intensity;
+      /// Current temperature
+      double temperature;
+      /// Cost of the best solution (NaN if none)
+      double best;
+      /// Number of improvements of the best solution
+      unsigned long int improvements;
+      /// Nodes and failures of the sub-engines
+      unsigned long int node;
+      unsigned long int fail;
+      /// Seconds since the last improvement (or since creation)
+      double since_improvement;
+    };
+  protected:
+    /// The identifier of the engine within the process
+    unsigned long int id;
+    /// Whether the metrics are served by the exporter
+    bool published;
+    /// Creation time
+    Clock::time_point start;
+    std::atomic<unsigned long int> _iterations;
+    std::atomic<unsigned int> _intensity;
+    std::atomic<double> _temperature;
+    std::atomic<double> _best;
+    std::atomic<unsigned long int> _improvements;
+    std::atomic<unsigned long int> _node;
+    std::atomic<unsigned long int> _fail;
+    /// Time of the last improvement (in nanoseconds since creation)
+    std::atomic<long long int> _improved;
+    /// Time (in nanoseconds since creation, -1 if none) and iterations of the first iteration of each of the last seconds, by second modulo window
+    std::atomic<long long int> _mark_time[window];
+    std::atomic<unsigned long int> _mark_iterations[window];
+    friend class LNSMetricsExporter;
+  public:
+    /// Initialize, and publish on \a port (if not 0) and/or Unix socket \a path (if not empty)
+    LNSMetrics(unsigned int port = 0, const char* path = NULL);
+    /// Withdraw from the exporter
+    ~LNSMetrics(void);
+    /// Record the start of an iteration
+    void iteration(unsigned long int iterations, unsigned int intensity, double temperature);
+    /// Record the search statistics \a s of the sub-engines
+    void search(const Statistics& s);
+    /// Record an improvement of the best solution to \a cost
+    void improvement(double cost);
+    /// Return a copy of the counters
+    Snapshot snapshot(void) const;
+  private:
+    LNSMetrics(const LNSMetrics&);
+    LNSMetrics& operator=(const LNSMetrics&);
+  };
+
+  forceinline void
+  LNSMetrics::iteration(unsigned long int iterations, unsigned int intensity, double temperature) {
+    _iterations.store(iterations, std::memory_order_relaxed);
+    _intensity.store(intensity, std::memory_order_relaxed);
+    _temperature.store(temperature, std::memory_order_relaxed);
+    if (!published)
+      return;
+    long long int now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    long long int second = now / 1000000000LL;
+    unsigned int slot = static_cast<unsigned int>(second % window);
+    // Mark the first iteration of every second
+    if (_mark_time[slot].load(std::memory_order_relaxed) / 1000000000LL != second
+        || _mark_time[slot].load(std::memory_order_relaxed) < 0) {
+      _mark_iterations[slot].store(iterations, std::memory_order_relaxed);
+      _mark_time[slot].store(now, std::memory_order_release);
+    }
+  }
+
+  forceinline void
+  LNSMetrics::search(const Statistics& s) {
+    _node.store(s.node, std::memory_order_relaxed);
+    _fail.store(s.fail, std::memory_order_relaxed);
+  }
+
+  forceinline void
+  LNSMetrics::improvement(double cost) {
+    _best.store(cost, std::memory_order_relaxed);
+    _improvements.fetch_add(1, std::memory_order_relaxed);
+    _improved.store(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(),
+                    std::memory_order_relaxed);
+  }
+
+}}}
+
+#endif
+
+// STATISTICS: search-other
@@ -0,0 +1,115 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_META_PERF_COUNTERS_HH__
+#define __GECODE_SEARCH_META_PERF_COUNTERS_HH__
+
+#include <gecode/kernel.hh>
+#include <chrono>
+#include <iostream>
+
+namespace Gecode { namespace Search { namespace Meta {
+
+  /// The phases of an LNS iteration that can be profiled
+  enum LNSPhase {
+    LNS_PHASE_CLONE,      ///< Cloning root into a fresh neighbor
+    LNS_PHASE_RELAX,      ///< Relaxing current into the neighbor (and posting branching and bound)
+    LNS_PHASE_PROPAGATE,  ///< Propagating the neighbor
+    LNS_PHASE_SEARCH,     ///< Running the sub-engine on the neighbor
+    LNS_PHASE_POLISH,     ///< Polishing the neighboring solution by native local search
+    LNS_PHASE_ACCEPT,     ///< Deciding about (and storing) the neighboring solution
+    LNS_PHASES
+  };
+
+  /**
+   * \brief Per-phase wall-clock and hardware counter aggregation
+   *
+   * Counters are read through Linux perf_event_open for the calling thread
+   * only, hence work done by parallel sub-engines is not accounted for.
+   * Counters that cannot be opened (non-Linux systems, restrictive
+   * perf_event_paranoid settings, virtual machines) are reported as
+   * unavailable, wall-clock times are always collected.
+   */
+  class PerfCounters {
+  public:
+    /// The hardware events being counted
+    enum Counter { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, COUNTERS };
+  protected:
+    typedef std::chrono::steady_clock Clock;
+    /// Whether profiling is enabled at all
+    bool enabled;
+    /// File descriptor of the counter group leader (-1 if none)
+    int leader;
+    /// File descriptor of each counter (-1 if unavailable)
+    int fd[COUNTERS];
+    /// Position of each counter in the group read (-1 if unavailable)
+    int slot[COUNTERS];
+    /// Number of counters in the group
+    int opened;
+    /// Counter values at the beginning of the current phase
+    unsigned long long start[COUNTERS];
+    /// Time at the beginning of the current phase
+    Clock::time_point start_time;
+    /// Aggregated counter values per phase
+    unsigned long long total[LNS_PHASES][COUNTERS];
+    /// Aggregated wall-clock time (in nanoseconds) per phase
+    unsigned long long total_time[LNS_PHASES];
+    /// Number of times each phase has been executed
+    unsigned long long calls[LNS_PHASES];
+    /// Read all available counters into \a v
+    void read(unsigned long long v[COUNTERS]) const;
+  public:
+    /// Initialize (and open the counters if \a enabled0)
+    PerfCounters(bool enabled0 = false);
+    /// Release the counters
+    ~PerfCounters(void);
+    /// Whether profiling is enabled
+    bool active(void) const { return enabled; }
+    /// Whether counter \a c could be opened
+    bool available(Counter c) const { return slot[c] >= 0; }
+    /// Start measuring phase \a p
+    void begin(LNSPhase p);
+    /// Stop measuring phase \a p and aggregate the measurements
+    void end(LNSPhase p);
+    /// Print the aggregated measurements
+    void print(std::ostream& os) const;
+  private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+  };
+
+  forceinline void
+  PerfCounters::begin(LNSPhase) {
+    if (!enabled)
+      return;
+    read(start);
+    start_time = Clock::now();
+  }
+
+  forceinline void
+  PerfCounters::end(LNSPhase p) {
+    if (!enabled)
+      return;
+    Clock::time_point t = Clock::now();
+    unsigned long long v[COUNTERS];
+    read(v);
+    for (int c = 0; c < COUNTERS; c++)
+      total[p][c] += v[c] - start[c];
+    total_time[p] += std::chrono::duration_cast<std::chrono::nanoseconds>(t - start_time).count();
+    calls[p]++;
+  }
+
+}}}
+
+#endif
+
+// STATISTICS: search-other
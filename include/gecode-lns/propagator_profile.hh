@@ -0,0 +1,95 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_META_PROPAGATOR_PROFILE_HH__
+#define __GECODE_SEARCH_META_PROPAGATOR_PROFILE_HH__
+
+#include <gecode/kernel.hh>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace Gecode { namespace Search { namespace Meta {
+
+  /**
+   * \brief Per-propagator aggregation of the executions in the neighborhoods
+   *
+   * A tracer for propagation and commit events, posted in every neighbor
+   * (and in every part of a decomposition) only, so that the executions of
+   * the neighborhood searches are profiled, but not those of the initial
+   * solution searches, polishing, completions or bound refreshes. Executions
+   * are aggregated by the demangled type of the propagator (e.g., the
+   * circuit and element propagators of the TSP model), counting their
+   * outcomes: a NOFIX, FAILED or SUBSUMED outcome means that the propagator
+   * pruned. The trace hooks only signal the end of an execution, hence its
+   * time is measured from the previous event of the same thread (a commit,
+   * another execution, or a call to mark()).
+   */
+  class PropagatorProfile : public Tracer {
+  protected:
+    typedef std::chrono::steady_clock Clock;
+    /// The aggregated executions of a type of propagator
+    class Entry {
+    public:
+      unsigned long long calls;
+      unsigned long long time;
+      unsigned long long outcome[4];
+      Entry(void) : calls(0), time(0) { outcome[0] = outcome[1] = outcome[2] = outcome[3] = 0; }
+    };
+    /// Whether profiling is enabled at all
+    bool enabled;
+    /// Aggregated executions per type of propagator
+    std::map<std::string, Entry> entries;
+    /// The type of a propagator and the entry of its executions
+    class Kind {
+    public:
+      const std::type_info* type;
+      Entry* entry;
+      Kind(void) : type(NULL), entry(NULL) {}
+    };
+    /// Kind of each propagator seen so far, by id (subsumed propagators cannot be inspected)
+    std::unordered_map<unsigned int, Kind> kinds;
+    /// Return the entry of the executions of \a p (demangling its type only if not seen yet)
+    Entry& entry(unsigned int id, const Propagator* p);
+    /// Protects the aggregation from parallel sub-engines
+    std::mutex m;
+    /// Time of the last event of the calling thread
+    static Clock::time_point& last(void);
+  public:
+    /// Initialize (collecting executions only if \a enabled0)
+    PropagatorProfile(bool enabled0 = false);
+    /// Whether profiling is enabled
+    bool active(void) const { return enabled; }
+    /// Post the tracer in neighbor \a home (if enabled)
+    void post(Space& home);
+    /// Start timing the next execution on the calling thread (before a status() not preceded by a commit)
+    void mark(void);
+    /// Aggregate an execution
+    virtual void propagate(const Space& home, const PropagateTraceInfo& pti);
+    /// Restart timing after a commit
+    virtual void commit(const Space& home, const CommitTraceInfo& cti);
+    /// Print the aggregated executions, most expensive first
+    void print(std::ostream& os) const;
+  private:
+    PropagatorProfile(const PropagatorProfile&);
+    PropagatorProfile& operator=(const PropagatorProfile&);
+  };
+
+}}}
+
+#endif
+
+// STATISTICS: search-other
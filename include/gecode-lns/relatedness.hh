@@ -0,0 +1,67 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_META_RELATEDNESS_HH__
+#define __GECODE_SEARCH_META_RELATEDNESS_HH__
+
+#include "gecode-lns/relax.hh"
+#include <unordered_map>
+#include <vector>
+
+namespace Gecode { namespace Search { namespace Meta {
+
+  /**
+   * \brief Relatedness of the relaxable variables learned from improving moves
+   *
+   * Every improving move is observed through the assignments before and
+   * after it, and each pair of variables that changed together gains
+   * 1/(number of changed variables). Counts are kept in a dense matrix for
+   * models with at most dense_limit variables, in a sparse graph
+   * otherwise. Neighborhoods are grown from a random seed, adding each
+   * time the variable most related to the ones already freed (or another
+   * random seed, if none is related).
+   */
+  class LNSRelatedness {
+  public:
+    /// Largest number of variables kept in a dense matrix
+    static const unsigned int dense_limit = 1024;
+    /// Moves changing more variables are ignored (they tell little about the structure)
+    static const unsigned int max_changed = 256;
+  protected:
+    /// The number of variables
+    unsigned int n;
+    /// Dense co-change counts (row-major), if n <= dense_limit
+    std::vector<float> dense;
+    /// Sparse co-change counts, otherwise
+    std::vector<std::unordered_map<unsigned int, float> > sparse;
+    /// Scratch: changed variables, relatedness to the freed ones, variables with a positive one
+    std::vector<unsigned int> changed;
+    std::vector<double> score;
+    std::vector<unsigned int> touched;
+    /// Clear the counts for \a n0 variables
+    void resize(unsigned int n0);
+    /// Add the relations of variable \a i to the scores
+    void spread(unsigned int i);
+  public:
+    /// Initialize with no relations
+    LNSRelatedness(void) : n(0) {}
+    /// Record the variables that changed from assignment \a a to assignment \a b
+    void observe(const std::vector<int>& a, const std::vector<int>& b);
+    /// Free \a k out of \a n0 variables along the strongest relations (clearing \a keep for them), return how many
+    unsigned int grow(unsigned int n0, unsigned int k, LNSRandom& r, std::vector<bool>& keep);
+  };
+
+}}}
+
+#endif
+
+// STATISTICS: search-other
@@ -0,0 +1,154 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef _LNS_RELAX_H
+#define _LNS_RELAX_H
+
+#include <gecode/kernel.hh>
+#include <gecode/int.hh>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Gecode {
+
+  /**
+   * \brief Source of randomness for the relaxations of an LNS engine
+   *
+   * Wraps the random number generator of the engine together with a
+   * permutation of the variable indices that is kept across calls, so that
+   * drawing a subset of \a k out of \a n indices is a partial Fisher-Yates
+   * shuffle costing O(k) (after the first draw for a given \a n) and no
+   * allocation.
+   */
+  class LNSRandom {
+  protected:
+    /// The random number generator of the engine
+    Rnd& r;
+    /// A permutation of 0..n-1 whose first k entries are the last draw
+    std::vector<unsigned int> p;
+    /// The size of the last draw
+    unsigned int k;
+  public:
+    /// Initialize with the random number generator \a r0
+    LNSRandom(Rnd& r0) : r(r0), k(0) {}
+    /// Return a random number in 0..n-1
+    unsigned int operator ()(unsigned int n) { return r(n); }
+    /// Draw \a k0 distinct indices out of 0..n-1 uniformly at random, return them
+    const unsigned int* subset(unsigned int n, unsigned int k0);
+    /// Draw \a k0 distinct indices favouring the highest contributions \a c (the larger \a determinism, the more greedily)
+    const unsigned int* worst(const std::vector<double>& c, unsigned int k0, double determinism);
+    /// Number of indices the last draw was made from
+    unsigned int size(void) const { return p.size(); }
+    /// Number of indices drawn last
+    unsigned int drawn(void) const { return k; }
+    /// Return the \a i-th index drawn last (for \a i < drawn()), or not drawn (for drawn() <= \a i < size())
+    unsigned int operator [](unsigned int i) const { return p[i]; }
+  };
+
+  forceinline const unsigned int*
+  LNSRandom::subset(unsigned int n, unsigned int k0) {
+    if (p.size() != n) {
+      p.resize(n);
+      for (unsigned int i = 0; i < n; i++)
+        p[i] = i;
+    }
+    k = std::min(k0, n);
+    for (unsigned int i = 0; i < k; i++)
+      std::swap(p[i], p[i + r(n - i)]);
+    return p.empty() ? NULL : &p[0];
+  }
+
+  /*
+   * The indices are ranked by decreasing contribution, the i-th pick takes
+   * the one at position y^determinism * (n - i) among the remaining ones
+   * (y uniform in [0,1)), preserving the order of the others.
+   */
+  forceinline const unsigned int*
+  LNSRandom::worst(const std::vector<double>& c, unsigned int k0, double determinism) {
+    unsigned int n = c.size();
+    p.resize(n);
+    for (unsigned int i = 0; i < n; i++)
+      p[i] = i;
+    std::stable_sort(p.begin(), p.end(), [&c](unsigned int a, unsigned int b) { return c[a] > c[b]; });
+    k = std::min(k0, n);
+    const unsigned int scale = 1U << 30;
+    for (unsigned int i = 0; i < k; i++) {
+      double y = static_cast<double>(r(scale)) / scale;
+      unsigned int j = std::min(n - 1, i + static_cast<unsigned int>(std::pow(y, determinism) * (n - i)));
+      std::rotate(p.begin() + i, p.begin() + j, p.begin() + j + 1);
+    }
+    return p.empty() ? NULL : &p[0];
+  }
+
+  /**
+   * \brief Relax the indices drawn last by \a r
+   *
+   * Fixes every variable of \a x (in the neighbor \a home) that has not
+   * been drawn to the value of the corresponding variable of \a y (in the
+   * current solution). Returns the number of free variables.
+   */
+  template<class VarArray>
+  forceinline unsigned int
+  relax_drawn(Space& home, VarArray& x, const VarArray& y, const LNSRandom& r) {
+    for (unsigned int i = r.drawn(); i < r.size(); i++)
+      rel(home, x[r[i]], IRT_EQ, y[r[i]].val());
+    return r.drawn();
+  }
+
+  /// Relax \a free variables of \a x chosen uniformly at random, fix the others to their values in \a y
+  template<class VarArray>
+  forceinline unsigned int
+  relax_random(Space& home, VarArray& x, const VarArray& y, unsigned int free, LNSRandom& r) {
+    r.subset(y.size(), free);
+    return relax_drawn(home, x, y, r);
+  }
+
+  /// Relax a random window of \a free consecutive (cyclically) variables of \a x, fix the others to their values in \a y
+  template<class VarArray>
+  forceinline unsigned int
+  relax_window(Space& home, VarArray& x, const VarArray& y, unsigned int free, LNSRandom& r) {
+    unsigned int n = y.size();
+    if (n == 0)
+      return 0;
+    free = std::min(free, n);
+    unsigned int first = r(n);
+    for (unsigned int i = free; i < n; i++) {
+      unsigned int j = (first + i) % n;
+      rel(home, x[j], IRT_EQ, y[j].val());
+    }
+    return free;
+  }
+
+  /**
+   * \brief Restrict \a free random variables of \a x around their values in \a y, fix the others
+   *
+   * Each relaxed variable keeps only the values within \a radius from its
+   * value in the current solution, so that many variables can move a little
+   * within a neighborhood of the same size.
+   */
+  template<class VarArray>
+  forceinline unsigned int
+  relax_domain(Space& home, VarArray& x, const VarArray& y, unsigned int free, int radius, LNSRandom& r) {
+    relax_random(home, x, y, free, r);
+    for (unsigned int i = 0; i < r.drawn(); i++) {
+      int v = y[r[i]].val();
+      dom(home, x[r[i]], v - radius, v + radius);
+    }
+    return r.drawn();
+  }
+
+}
+
+#endif
+
+// STATISTICS: search-other
@@ -0,0 +1,111 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_LNS_SOLVER_HH__
+#define __GECODE_LNS_SOLVER_HH__
+
+#include "gecode-lns/lns.hh"
+
+namespace Gecode {
+
+  /**
+   * \brief A persistent LNS solver answering a sequence of solve requests
+   *
+   * The meta-engine, with its sub-engines, stop objects and workers, is
+   * built by the first request and kept by the following ones, which only
+   * replace its root space (see LNS<E,T>::reinit), so that the setup of a
+   * request reduces to propagating and cloning its instance. Each request
+   * brings its own instance (a new one, or the same model with updated
+   * data) and time budget. Search::Meta::LNS::lns_options must be set
+   * before the first request.
+   */
+  template<template<class> class E, class T>
+  class LNSSolver {
+  protected:
+    /// The stop object enforcing the budget of a request
+    Search::DeadlineStop stop;
+    /// The options of the engine
+    Search::Options opt;
+    /// The meta-engine (built by the first request)
+    LNS<E,T>* engine;
+    /// Whether the search of the last request has been completed
+    bool finished;
+    /// The statistics of the last request
+    Search::Statistics stats;
+  public:
+    /// Initialize a solver with options \a o
+    LNSSolver(const Search::Options& o);
+    /// Delete the engine
+    ~LNSSolver(void);
+    /// Solve instance \a s (which is deleted) within \a time milliseconds (zero for no limit), return the best solution (NULL if none has been found)
+    T* solve(T* s, double time);
+    /// Whether the search of the last request has been completed (the solution is optimal, within the gap, or there is none)
+    bool complete(void) const;
+    /// Return the statistics of the last request
+    Search::Statistics statistics(void) const;
+  };
+
+  template<template<class> class E, class T>
+  LNSSolver<E,T>::LNSSolver(const Search::Options& o)
+    : stop(0), opt(o), engine(NULL), finished(false) {
+    opt.clone = true;
+    opt.stop = &stop;
+  }
+
+  template<template<class> class E, class T>
+  LNSSolver<E,T>::~LNSSolver(void) {
+    delete engine;
+  }
+
+  template<template<class> class E, class T>
+  T*
+  LNSSolver<E,T>::solve(T* s, double time) {
+    stop.limit(static_cast<unsigned long int>(time));
+    stop.reset();
+    Search::Statistics before;
+    if (engine == NULL)
+      engine = new LNS<E,T>(s, opt);
+    else {
+      before = engine->statistics();
+      engine->reinit(s);
+    }
+    delete s;
+    T* best = NULL;
+    while (T* n = engine->next()) {
+      delete best;
+      best = n;
+    }
+    // The engine gave up without being stopped: nothing left to search
+    finished = !stop.stop(engine->statistics(), opt);
+    stats = engine->statistics();
+    stats.node -= before.node;
+    stats.fail -= before.fail;
+    return best;
+  }
+
+  template<template<class> class E, class T>
+  forceinline bool
+  LNSSolver<E,T>::complete(void) const {
+    return finished;
+  }
+
+  template<template<class> class E, class T>
+  forceinline Search::Statistics
+  LNSSolver<E,T>::statistics(void) const {
+    return stats;
+  }
+
+}
+
+#endif
+
+// STATISTICS: search-other
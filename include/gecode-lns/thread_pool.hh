@@ -0,0 +1,91 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#ifndef __GECODE_SEARCH_THREAD_POOL_HH__
+#define __GECODE_SEARCH_THREAD_POOL_HH__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Gecode { namespace Search {
+
+  /**
+   * \brief Work-stealing thread pool
+   *
+   * Every worker owns a deque of tasks: tasks submitted by a worker go to
+   * the back of its own deque and are taken back from there (so that the
+   * continuation of a task stays on the same thread), tasks submitted from
+   * outside are distributed round-robin. An idle worker steals from the
+   * front of the deques of the other workers.
+   */
+  class WorkStealingPool {
+  public:
+    typedef std::function<void(void)> Task;
+  protected:
+    /// The deque of a worker
+    class Worker {
+    public:
+      std::mutex m;
+      std::deque<Task> tasks;
+    };
+    /// The workers
+    std::vector<Worker*> workers;
+    /// The threads running the workers
+    std::vector<std::thread> threads;
+    /// Protects the counters below
+    std::mutex m;
+    /// Signalled when tasks are available (or the pool is shutting down)
+    std::condition_variable work;
+    /// Signalled when all tasks have been run
+    std::condition_variable done;
+    /// Number of tasks submitted but not yet taken
+    unsigned long int queued;
+    /// Number of tasks being run
+    unsigned long int running;
+    /// Whether the pool is shutting down
+    bool quit;
+    /// Next worker for tasks submitted from outside the pool
+    unsigned int next;
+    /// Take a task for worker \a w (own deque first, then steal)
+    bool take(unsigned int w, Task& t);
+    /// Main loop of worker \a w
+    void run(unsigned int w);
+  public:
+    /// Start a pool with \a n workers
+    WorkStealingPool(unsigned int n);
+    /// Wait for all tasks and stop the workers
+    ~WorkStealingPool(void);
+    /// Submit task \a t
+    void submit(const Task& t);
+    /// Wait until all tasks (including those submitted by tasks) have been run
+    void wait(void);
+    /// Return the number of workers
+    unsigned int size(void) const;
+  private:
+    WorkStealingPool(const WorkStealingPool&);
+    WorkStealingPool& operator=(const WorkStealingPool&);
+  };
+
+  inline unsigned int
+  WorkStealingPool::size(void) const {
+    return static_cast<unsigned int>(workers.size());
+  }
+
+}}
+
+#endif
+
+// STATISTICS: search-other
@@ -0,0 +1,121 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "gecode-lns/deadline_stop.hh"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace Gecode { namespace Search {
+
+    /**
+     * The timer thread shared by all deadline stops: pending deadlines are
+     * kept ordered, the thread sleeps until the earliest one and flips the
+     * flag of every stop whose deadline has passed.
+     */
+    class DeadlineTimer {
+    protected:
+        typedef DeadlineStop::Clock Clock;
+        std::mutex m;
+        std::condition_variable c;
+        std::multimap<Clock::time_point, DeadlineStop*> pending;
+
+        void run(void) {
+            std::unique_lock<std::mutex> lock(m);
+            while (true) {
+                if (pending.empty()) {
+                    c.wait(lock);
+                    continue;
+                }
+                // Copy the deadline, its entry may be withdrawn while waiting
+                Clock::time_point earliest = pending.begin()->first;
+                if (c.wait_until(lock, earliest) == std::cv_status::timeout) {
+                    Clock::time_point now = Clock::now();
+                    while (!pending.empty() && pending.begin()->first <= now) {
+                        DeadlineStop* s = pending.begin()->second;
+                        s->armed = false;
+                        s->expired.store(true, std::memory_order_relaxed);
+                        pending.erase(pending.begin());
+                    }
+                }
+            }
+        }
+
+        /** Remove the pending deadline of \a s (lock must be held) */
+        void withdraw(DeadlineStop* s) {
+            if (!s->armed)
+                return;
+            typedef std::multimap<Clock::time_point, DeadlineStop*>::iterator iterator;
+            std::pair<iterator, iterator> r = pending.equal_range(s->deadline);
+            for (iterator i = r.first; i != r.second; i++)
+                if (i->second == s) {
+                    pending.erase(i);
+                    break;
+                }
+            s->armed = false;
+        }
+
+    public:
+        DeadlineTimer(void) {
+            std::thread t(&DeadlineTimer::run, this);
+            t.detach();
+        }
+
+        /** Arm the deadline of \a s (replacing a pending one) */
+        void arm(DeadlineStop* s) {
+            std::lock_guard<std::mutex> lock(m);
+            withdraw(s);
+            s->expired.store(false, std::memory_order_relaxed);
+            if (s->l == 0)
+                return;
+            s->deadline = Clock::now() + std::chrono::milliseconds(s->l);
+            s->armed = true;
+            bool earliest = pending.empty() || s->deadline < pending.begin()->first;
+            pending.insert(std::make_pair(s->deadline, s));
+            if (earliest)
+                c.notify_one();
+        }
+
+        /** Withdraw the pending deadline of \a s */
+        void cancel(DeadlineStop* s) {
+            std::lock_guard<std::mutex> lock(m);
+            withdraw(s);
+        }
+
+        /** The timer (never destroyed, as stops may outlive static destruction) */
+        static DeadlineTimer& timer(void) {
+            static DeadlineTimer* t = new DeadlineTimer();
+            return *t;
+        }
+    };
+
+    DeadlineStop::DeadlineStop(unsigned long int l0)
+      : expired(false), l(l0), armed(false) {}
+
+    DeadlineStop::~DeadlineStop(void) {
+        DeadlineTimer::timer().cancel(this);
+    }
+
+    void
+    DeadlineStop::limit(unsigned long int l0) {
+        l = l0;
+    }
+
+    void
+    DeadlineStop::reset(void) {
+        DeadlineTimer::timer().arm(this);
+    }
+
+}}
+
+// STATISTICS: search-other
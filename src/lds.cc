@@ -0,0 +1,150 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "gecode-lns/lds.hh"
+#include <algorithm>
+
+namespace Gecode { namespace Search {
+
+    LDS::LDS(Space* s, const Options& o, bool improve0)
+      : opt(o), root(NULL), probe(0), started(false), cut(false), improve(improve0),
+        best(NULL), generation(0), has_stopped(false), shared(o.threads == 1) {
+        if (s != NULL)
+            root = o.clone ? s->clone(shared) : s;
+    }
+
+    void
+    LDS::clear(void) {
+        for (unsigned int i = 0; i < stack.size(); i++)
+            delete stack[i].s;
+        stack.clear();
+    }
+
+    Space*
+    LDS::next(void) {
+        has_stopped = false;
+        while (true) {
+            if (stack.empty())
+            {
+                if (root == NULL)
+                    return NULL;
+                // The tree has been explored: the last probe did not cut anything, or could not take more discrepancies
+                if (started && (!cut || probe >= opt.d_l))
+                {
+                    delete root;
+                    root = NULL;
+                    return NULL;
+                }
+                if (started)
+                    probe++;
+                started = true;
+                cut = false;
+                stack.push_back(Node(root->clone(shared), 0, 0, 0));
+            }
+
+            if (opt.stop != NULL && opt.stop->stop(stats, opt))
+            {
+                has_stopped = true;
+                return NULL;
+            }
+
+            Node n = stack.back();
+            stack.pop_back();
+            if (improve && best != NULL && n.mark != generation)
+            {
+                n.s->constrain(*best);
+                n.mark = generation;
+            }
+
+            switch (n.s->status(stats)) {
+                case SS_FAILED:
+                    stats.fail++;
+                    delete n.s;
+                    break;
+                case SS_SOLVED:
+                    // Solutions taking fewer discrepancies have been reported by earlier probes
+                    if (n.d < probe)
+                    {
+                        delete n.s;
+                        break;
+                    }
+                    if (improve)
+                    {
+                        delete best;
+                        best = n.s->clone(shared);
+                        generation++;
+                    }
+                    return n.s;
+                case SS_BRANCH:
+                {
+                    stats.node++;
+                    // The depth of the tree, as in the other engines: the branching nodes on the path to this one
+                    stats.depth = std::max(stats.depth, static_cast<size_t>(n.level + 1));
+                    const Choice* ch = n.s->choice();
+                    // The first alternative is explored first and reuses the space of the node
+                    for (unsigned int a = ch->alternatives(); a-- > 0; )
+                    {
+                        unsigned int d = n.d + (a > 0 ? 1 : 0);
+                        if (d > probe)
+                        {
+                            cut = true;
+                            continue;
+                        }
+                        Space* c = a > 0 ? n.s->clone(shared) : n.s;
+                        c->commit(*ch, a);
+                        stack.push_back(Node(c, d, n.mark, n.level + 1));
+                    }
+                    delete ch;
+                }
+                    break;
+            }
+        }
+        GECODE_NEVER;
+
+        return NULL;
+    }
+
+    Statistics
+    LDS::statistics(void) const {
+        return stats;
+    }
+
+    bool
+    LDS::stopped(void) const {
+        return has_stopped;
+    }
+
+    void
+    LDS::reset(Space* s) {
+        clear();
+        delete root;
+        delete best;
+        root = s;
+        best = NULL;
+        probe = 0;
+        started = false;
+        cut = false;
+        generation = 0;
+        has_stopped = false;
+        // As in the other engines, the depth is the one of the current search
+        stats.depth = 0;
+    }
+
+    LDS::~LDS(void) {
+        clear();
+        delete root;
+        delete best;
+    }
+
+}}
+
+// STATISTICS: search-other
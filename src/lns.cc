@@ -16,13 +16,14 @@
  namespace Gecode { namespace Search {
 
    Engine*
-   lns(Space* s, size_t sz, TimeStop* e_stop,
-       Engine* se, Engine* e, Search::Statistics& st, const Options& o) {
+   lns(Space* s, size_t sz, LNSMetaStop* e_stop,
+       Engine* se, Engine* e, const std::vector<Engine*>& copies, const std::vector<Engine*>& racers, LNSRaceStop* race_stop, LNSParts* parts, LNSWorkers* workers,
+       Search::Statistics& st, const Options& o, bool instrumented) {
  #ifdef GECODE_HAS_THREADS
      Options to = o.expand();
-     return new Meta::LNS(s,sz,e_stop,se,e,st,to);
+     return new Meta::LNS(s,sz,e_stop,se,e,copies,racers,race_stop,parts,workers,st,to,instrumented);
  #else
-     return new Meta::LNS(s,sz,e_stop,se,e,st,o);
+     return new Meta::LNS(s,sz,e_stop,se,e,copies,racers,race_stop,parts,workers,st,o,instrumented);
  #endif
    }
 
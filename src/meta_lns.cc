@@ -12,7 +12,8 @@
 
 #include "gecode-lns/meta_lns.hh"
 #include "gecode-lns/lns_space.hh"
-#include <list>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 
@@ -32,30 +33,70 @@ namespace Gecode { namespace Search { namespace Meta {
     Space* LNS::next(void) {
 
         while (true) {
+            Space* n = step();
+            if (n != NULL || halted)
+                return n;
+        }
+        GECODE_NEVER;
+
+        return NULL;
+    }
+
+    Space* LNS::step(void) {
+
+        // The root has failed, or the best solution is (close enough to) optimal
+        if (root == NULL || gap_closed())
+        {
+            halted = true;
+            return NULL;
+        }
 
-            /** We have to distinguish at least these two cases:
-             *
-             *  1. we landed here for the first time (or because of a restart)
-             *      --> current == NULL
-             *  2. we just discovered a new best solution in the previous next() call
-             *      --> current != NULL
-             */
+        // The workers of a deterministic parallel search do the actual work (until the next improvement)
+        if (workers != NULL)
+        {
+            Space* n = epochs();
+            halted = n == NULL;
+            return n;
+        }
+
+        return iterate();
+    }
+
+    Space* LNS::iterate(void) {
+
+        halted = false;
+
+        /** We have to distinguish at least these two cases:
+         *
+         *  1. we landed here for the first time (or because of a restart)
+         *      --> current == NULL
+         *  2. we just discovered a new best solution in the previous next() call
+         *      --> current != NULL
+         */
 
-            // We landed in this function for the first time or after a restart
-            if (current == NULL)
+        // We landed in this function for the first time or after a restart
+        if (current == NULL)
+        {
+            Space* n;
+            if (starting)
+            {
+                // Resume the initial solution search stopped by the previous step (where it stopped)
+                starting = false;
+                n = racers.empty() ? se->next() : race(NULL);
+            }
+            else
             {
                 // Reset default search parameters (including Simulated Annealing ones)
-                intensity = lns_options->minIntensity();
-                temperature = lns_options->SAstartTemperature();
+                intensity = params->minIntensity();
+                temperature = params->SAstartTemperature();
                 idle_iterations = 0;
                 neighbors_accepted = 0;
                 current = root->clone(shared);
-                LNSAbstractSpace* _current = dynamic_cast<LNSAbstractSpace*>(current);
 
                 // In a restart, constraint cost if stated by the options
                 if (best != NULL)
                 {
-                    switch (lns_options->constrainType()) {
+                    switch (params->constrainType()) {
                         case LNS_CT_LOOSE:
                             dynamic_cast<LNSAbstractSpace*>(current)->constrain(*best, false, 0.0);
                             break;
@@ -75,211 +116,830 @@ namespace Gecode { namespace Search { namespace Meta {
                     }
                 }
 
-                _current->initial_solution_branching(restart);
-
                 // Look for (one) initial solution with same stopping condition as the overall LNS
-                se->reset(current);
-                Space* n = se->next();
+                if (racers.empty())
+                {
+                    start_branching(current, restart);
+                    se->reset(current);
+                    n = se->next();
+                }
+                else
+                    n = race(current);
+            }
+
+            // If we find a starting solution
+            if (n != NULL) {
 
-                // If we find a starting solution
-                if (n != NULL) {
+                remember(n);
+                metrics.search(statistics());
+
+                // Best is this solution if it wasn't there
+                if (best == NULL)
+                {
+                    metrics.improvement(dynamic_cast<LNSAbstractSpace*>(n)->objective());
+                    best = n->clone(shared);
+                    current = n->clone(shared);
+                    return n;
+                }
 
-                    // Best is this solution if it wasn't there
-                    if (best == NULL)
+                // Best is this solution if it's better than previous
+                LNSAbstractSpace* _n = dynamic_cast<LNSAbstractSpace*>(n);
+                if (_n->improving(*best, true))
+                {
+                    metrics.improvement(_n->objective());
+                    delete best;
+                    best = n->clone(shared);
+                    current = n->clone(shared);
+                    return n;
+                }
+                else
+                    current = n;
+            }
+            else
+            {
+                // Problem has no solution (or the search has been stopped), current is owned by se
+                current = NULL;
+                halted = true;
+                starting = m_stop != NULL && m_stop->stop(statistics(), opt);
+                return NULL;
+            }
+        }
+
+        // We landed in this function after a previous call to next or we are currently looping
+        else
+        {
+            // If we have run out of iterations for this intensity
+            if (idle_iterations > params->maxIterationsPerIntensity())
+            {
+                // If we still have intensity levels, increase intensity and reset idle iterations
+                if (intensity < params->maxIntensity())
+                    intensity++;
+                else {
+                    // just restart from minimum intensity (the whole restart with inferior cost is too hard on cp)
+                    intensity = params->minIntensity();
+                    // ... from one of the elite solutions, if any
+                    if (!elite.empty())
                     {
-                        best = n->clone(shared);
-                        current = n->clone(shared);
-                        return n;
+                        delete current;
+                        current = elite[r(elite.size())]->clone(shared);
                     }
+                    //restart++;
+                    //current = NULL;
+                    idle_iterations = 0;
+                    return NULL;
+                }
+                idle_iterations = 0;
+            }
 
-                    // Best is this solution if it's better than previous
+            // Handle Simulated Annealing variables
+            if (neighbors_accepted > params->SAneighborsAccepted())
+            {
+                temperature *= params->SAcoolingRate();
+                neighbors_accepted = 0;
+            }
+
+            // Periodically try to tighten the lower bound
+            iterations++;
+            metrics.iteration(iterations, intensity, temperature);
+            if (params->boundPeriod() > 0 && iterations % params->boundPeriod() == 0)
+            {
+                refresh_bound();
+                if (gap_closed())
+                {
+                    halted = true;
+                    return NULL;
+                }
+            }
+
+            LNSAbstractSpace* _current = dynamic_cast<LNSAbstractSpace*>(current);
+
+            // Depending on the constrain type, the slack granted to the cost of the neighbour
+            double delta = 0.0;
+            if (params->constrainType() == LNS_CT_SA)
+            {
+                double p = (double) r(RAND_MAX) / (double)RAND_MAX; // p should be a uniformly random number in (0, 1]
+                delta = -temperature * std::log(p);
+            }
+
+            // Improve several disjoint parts of current at once and merge the improvements
+            if (parts != NULL)
+            {
+                Space* n = decompose();
+                if (n != NULL)
+                {
                     LNSAbstractSpace* _n = dynamic_cast<LNSAbstractSpace*>(n);
+                    remember(n);
+                    delete current;
+                    current = n->clone(shared);
                     if (_n->improving(*best, true))
                     {
+                        metrics.improvement(_n->objective());
                         delete best;
                         best = n->clone(shared);
-                        current = n->clone(shared);
+                        idle_iterations = 0;
+                        intensity = params->minIntensity();
                         return n;
                     }
-                    else
-                        current = n;
+                    delete n;
                 }
-                else
-                    // Problem has no solution
+                idle_iterations++;
+                halted = m_stop != NULL && m_stop->stop(statistics(), opt);
+                return NULL;
+            }
+
+            // Every now and then relink current with a different elite solution instead of relaxing it
+            int guide = -1;
+            if (!elite.empty() && r(1000000) < params->eliteRelink() * 1000000)
+                guide = relink_guide();
+
+            bool worst = guide == -1 && params->relax() == LNS_RELAX_WORST;
+            bool learned = guide == -1 && params->relax() == LNS_RELAX_LEARNED;
+
+            // Skip the neighbourhood if the model can tell beforehand that it cannot satisfy the cost limit
+            if (guide == -1 && !worst && !learned && params->constrainType() != LNS_CT_NONE)
+            {
+                double limit = _current->objective() + delta;
+                double estimate = _current->neighborhood_bound(intensity, relax_rnd);
+                if (params->constrainType() == LNS_CT_STRICT ? estimate >= limit : estimate > limit)
+                {
+                    _current->neighborhood_skipped();
+                    idle_iterations++;
+                    halted = m_stop != NULL && m_stop->stop(statistics(), opt);
                     return NULL;
+                }
+            }
+
+            // Initialize empty neighbour
+            profile.begin(LNS_PHASE_CLONE);
+            Space* neighbor = root->clone(shared);
+            profile.end(LNS_PHASE_CLONE);
+
+            // Relax (fix) current solution into neighbour
+            profile.begin(LNS_PHASE_RELAX);
+            unsigned int relaxed_variables;
+            if (guide != -1)
+                relaxed_variables = relink(neighbor, guide);
+            else if (worst)
+                relaxed_variables = relax_worst(neighbor);
+            else if (learned)
+                relaxed_variables = relax_learned(neighbor);
+            else
+                relaxed_variables = _current->relax(neighbor, intensity, relax_rnd);
+            LNSAbstractSpace* _neighbor = dynamic_cast<LNSAbstractSpace*>(neighbor);
+
+            // Try the values of current (or best) first, if the model exposes them
+            if (params->guided() != LNS_GUIDE_NONE)
+            {
+                Space* g = params->guided() == LNS_GUIDE_BEST ? best : current;
+                dynamic_cast<LNSAbstractSpace*>(g)->assignment(values);
+                if (!values.empty())
+                    _neighbor->guide(values);
             }
 
-            // We landed in this function after a previous call to next or we are currently looping
+            // Use neighborhood branching
+            neighborhood_branching(neighbor);
+
+            // Depending on the constrain type, limit the cost of the neighbour
+            switch (params->constrainType()) {
+                case LNS_CT_LOOSE:
+                    _neighbor->constrain(*current, false, 0.0);
+                    break;
+                case LNS_CT_STRICT:
+                    _neighbor->constrain(*current, true, 0.0);
+                    break;
+                case LNS_CT_SA:
+                    _neighbor->constrain(*current, false, delta);
+                    break;
+                case LNS_CT_NONE:
+                default:
+                    break;
+            }
+            profile.end(LNS_PHASE_RELAX);
+
+            // Check for space status before solving
+            Space* n = NULL;
+            profile.begin(LNS_PHASE_PROPAGATE);
+            tracer->post(*neighbor);
+            tracer->mark();
+            SpaceStatus neighbor_status = neighbor->status(stats);
+            profile.end(LNS_PHASE_PROPAGATE);
+            if (neighbor_status == SS_SOLVED)
+                n = neighbor;
+            else if (neighbor_status == SS_FAILED)
+            {
+                delete neighbor;
+                n = NULL;
+            }
+
+            // If status is still unsolved, optimize
             else
             {
-                // If we have run out of iterations for this intensity
-                if (idle_iterations > lns_options->maxIterationsPerIntensity())
+                profile.begin(LNS_PHASE_SEARCH);
+                if (!copies.empty())
+                    choose_copies(relaxed_variables);
+                e->reset(neighbor);
+                size_t reset_depth = copies.empty() ? 0 : e->statistics().depth;
+
+                // Set time limit (a zero limit runs until a solution has been found, but not past
+                // the overall LNS stopping criterion)
+                double m = params->perVariable() ? relaxed_variables : 1;
+                if (params->deterministic() > 0)
+                    // A node limit, so that the outcome does not depend on the speed of the machine
+                    e_stop->limit(0, static_cast<unsigned long int>(params->neighborNodes() * m));
+                else if (params->neighborTime() > 0)
+                    e_stop->limit(static_cast<unsigned long int>(params->neighborTime() * m));
+                else
+                    e_stop->limit(0);
+                e_stop->reset();
+
+                // If we want to stop at first neighbour
+                if (params->stopAtFirstNeighbor())
                 {
-                    // If we still have intensity levels, increase intensity and reset idle iterations
-                    if (intensity < lns_options->maxIntensity())
-                        intensity++;
-                    else {
-			// just restart from minimum intensity (the whole restart with inferior cost is too hard on cp)
-                        intensity = lns_options->minIntensity();
-                        //restart++;
-                        //current = NULL;
-                        idle_iterations = 0;
-                        continue;
+                    n = e->next();
+                }
+                else
+                {
+                    // Find all solutions until time is up, n is the best one (the last one,
+                    // unless the engine does not look for ever improving solutions)
+                    Space* s;
+                    while ((s = e->next()) != NULL)
+                    {
+                        if (n == NULL || dynamic_cast<LNSAbstractSpace*>(s)->improving(*n, true))
+                        {
+                            delete n;
+                            n = s;
+                        }
+                        else
+                            delete s;
                     }
-                    idle_iterations = 0;
                 }
-
-                // Handle Simulated Annealing variables
-                if (neighbors_accepted > lns_options->SAneighborsAccepted())
+                profile.end(LNS_PHASE_SEARCH);
+                metrics.search(statistics());
+                if (!copies.empty())
                 {
-                    temperature *= lns_options->SAcoolingRate();
-                    neighbors_accepted = 0;
+                    // The depth is the one of this search only if the engine clears it on reset
+                    if (reset_depth > 0)
+                        depth_reported = false;
+                    if (depth_reported)
+                        depth = 0.9 * depth + 0.1 * e->statistics().depth / std::max(1U, relaxed_variables);
                 }
+            }
 
-                // Initialize empty neighbour
-                Space* neighbor = root->clone(shared);
-                LNSAbstractSpace* _current = dynamic_cast<LNSAbstractSpace*>(current);
-
-                // Relax (fix) current solution into neighbour
-                unsigned int relaxed_variables = _current->relax(neighbor, intensity);
-                LNSAbstractSpace* _neighbor = dynamic_cast<LNSAbstractSpace*>(neighbor);
-
-                // Use neighborhood branching
-                _neighbor->neighborhood_branching();
-
-                // Depending on the constrain type, limit the cost of the neighbour
-                switch (lns_options->constrainType()) {
-                    case LNS_CT_LOOSE:
-                        _neighbor->constrain(*current, false, 0.0);
-                        break;
-                    case LNS_CT_STRICT:
-                        _neighbor->constrain(*current, true, 0.0);
-                        break;
-                    case LNS_CT_SA:
-                    {
-                        double p = (double) r(RAND_MAX) / (double)RAND_MAX; // p should be a uniformly random number in (0, 1]
-                        double delta = -temperature * std::log(p);
-                        _neighbor->constrain(*current, false, delta);
-                    }
-                        break;
-                    case LNS_CT_NONE:
-                    default:
-                        break;
+            // Improve the neighbour by the native local search of the model
+            if (n != NULL && params->polish())
+            {
+                profile.begin(LNS_PHASE_POLISH);
+                n = polished(n);
+                profile.end(LNS_PHASE_POLISH);
+            }
+
+            // If found a neighbour
+            profile.begin(LNS_PHASE_ACCEPT);
+            if (n != NULL)
+            {
+                neighbors_accepted++;
+                LNSAbstractSpace* _n = dynamic_cast<LNSAbstractSpace*>(n);
+
+                // Improving move: replace current, reset search
+                if (_n->improving(*best, true))
+                {
+                    remember(n);
+                    learn(n);
+                    metrics.improvement(_n->objective());
+                    delete best;
+                    best = n->clone(shared);
+                    delete current;
+                    current = n->clone(shared);
+                    idle_iterations = 0;
+                    intensity = params->minIntensity();
+                    profile.end(LNS_PHASE_ACCEPT);
+                    return n;
                 }
 
-                // Check for space status before solving
-                Space* n = NULL;
-                SpaceStatus neighbor_status = neighbor->status(stats);
-                if (neighbor_status == SS_SOLVED)
-                    n = neighbor;
-                else if (neighbor_status == SS_FAILED)
+                // Side move: replace current, but do not reset search
+                else if (params->constrainType() == LNS_CT_SA || params->constrainType() == LNS_CT_NONE || _n->improving(*current, params->constrainType() == LNS_CT_STRICT))
                 {
-                    delete neighbor;
+                    if (_n->improving(*current, true))
+                        learn(n);
+                    delete current;
+                    current = n->clone(shared);
+                    remember(current);
+                    delete n;
                     n = NULL;
                 }
+            }
+            profile.end(LNS_PHASE_ACCEPT);
+
+            // If the overall search has been stopped
+            if (m_stop != NULL && m_stop->stop(statistics(), opt))
+            {
+                // current is kept, so that a later call to next resumes from it
+                if (n != NULL)
+                    delete n;
+                idle_iterations++;
+                halted = true;
+                return NULL;
+            }
+        }
+        idle_iterations++;
+        return NULL;
+    }
+
+    void
+    LNS::refresh_bound(void) {
+        if (best == NULL)
+            return;
+        LNSAbstractSpace* _best = dynamic_cast<LNSAbstractSpace*>(best);
+        Space* s = root->clone(shared);
+        LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
+        _s->constrain(*best, true, 0.0);
+        // No solution improves over best: it is optimal
+        if (s->status(stats) == SS_FAILED)
+            bound = _best->objective();
+        else
+            bound = std::max(bound, std::min(_s->lower_bound(), _best->objective()));
+        delete s;
+    }
+
+    Space*
+    LNS::polished(Space* n) {
+        Space* p = root->clone(shared);
+        LNSAbstractSpace* _n = dynamic_cast<LNSAbstractSpace*>(n);
+        if (_n->polish(p) && p->status(stats) == SS_SOLVED && dynamic_cast<LNSAbstractSpace*>(p)->improving(*n, true))
+        {
+            delete n;
+            return p;
+        }
+        delete p;
+        return n;
+    }
+
+    /** Number of variables on which assignments \a a and \a b differ */
+    static unsigned int
+    distance(const std::vector<int>& a, const std::vector<int>& b) {
+        unsigned int d = 0;
+        for (unsigned int i = 0; i < a.size(); i++)
+            if (a[i] != b[i])
+                d++;
+        return d;
+    }
+
+    void
+    LNS::remember(Space* s) {
+        unsigned int size = params->eliteSize();
+        if (size == 0)
+            return;
+        LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
+        _s->assignment(values);
+        // The model does not expose its assignment
+        if (values.empty())
+            return;
 
-                // If status is still unsolved, optimize
+        // A full pool only admits s in place of the most similar of the solutions it improves on,
+        // so that the pool stays diverse
+        int replace = -1;
+        unsigned int closest = std::numeric_limits<unsigned int>::max();
+        for (unsigned int i = 0; i < elite.size(); i++)
+        {
+            unsigned int d = distance(values, elite_values[i]);
+            if (d == 0)
+                return;
+            if (elite.size() == size && d < closest && _s->improving(*elite[i], true))
+            {
+                closest = d;
+                replace = i;
+            }
+        }
+        if (elite.size() < size)
+        {
+            elite.push_back(s->clone(shared));
+            elite_values.push_back(values);
+        }
+        else if (replace != -1)
+        {
+            delete elite[replace];
+            elite[replace] = s->clone(shared);
+            elite_values[replace] = values;
+        }
+    }
+
+    int
+    LNS::relink_guide(void) {
+        dynamic_cast<LNSAbstractSpace*>(current)->assignment(values);
+        if (values.empty())
+            return -1;
+        unsigned int k = elite.size();
+        unsigned int first = r(k);
+        for (unsigned int i = 0; i < k; i++)
+        {
+            unsigned int g = (first + i) % k;
+            if (distance(values, elite_values[g]) > 0)
+                return g;
+        }
+        return -1;
+    }
+
+    unsigned int
+    LNS::relink(Space* neighbor, unsigned int g) {
+        // values holds the assignment of current (see relink_guide)
+        unsigned int relaxed = 0;
+        keep.resize(values.size());
+        for (unsigned int i = 0; i < values.size(); i++)
+        {
+            keep[i] = values[i] == elite_values[g][i];
+            if (!keep[i])
+                relaxed++;
+        }
+        dynamic_cast<LNSAbstractSpace*>(neighbor)->fix(values, keep);
+        return relaxed;
+    }
+
+    unsigned int
+    LNS::relax_worst(Space* neighbor) {
+        LNSAbstractSpace* _current = dynamic_cast<LNSAbstractSpace*>(current);
+        _current->contributions(contributions);
+        _current->assignment(values);
+        // The model does not support it, resort to its own relaxation
+        if (contributions.empty() || contributions.size() != values.size())
+            return _current->relax(neighbor, intensity, relax_rnd);
+        relax_rnd.worst(contributions, intensity, params->worstDeterminism());
+        keep.assign(values.size(), true);
+        for (unsigned int i = 0; i < relax_rnd.drawn(); i++)
+            keep[relax_rnd[i]] = false;
+        dynamic_cast<LNSAbstractSpace*>(neighbor)->fix(values, keep);
+        return relax_rnd.drawn();
+    }
+
+    unsigned int
+    LNS::relax_learned(Space* neighbor) {
+        LNSAbstractSpace* _current = dynamic_cast<LNSAbstractSpace*>(current);
+        _current->assignment(values);
+        // The model does not support it, resort to its own relaxation
+        if (values.empty())
+            return _current->relax(neighbor, intensity, relax_rnd);
+        unsigned int k = relatedness.grow(values.size(), intensity, relax_rnd, keep);
+        dynamic_cast<LNSAbstractSpace*>(neighbor)->fix(values, keep);
+        return k;
+    }
+
+    void
+    LNS::learn(Space* n) {
+        if (params->relax() != LNS_RELAX_LEARNED)
+            return;
+        dynamic_cast<LNSAbstractSpace*>(current)->assignment(values);
+        dynamic_cast<LNSAbstractSpace*>(n)->assignment(moved);
+        relatedness.observe(values, moved);
+    }
+
+    Space*
+    LNS::complete(const std::vector<int>& a) {
+        Space* s = root->clone(shared);
+        LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
+        keep.assign(a.size(), true);
+        _s->fix(a, keep);
+        switch (s->status(stats)) {
+            case SS_SOLVED:
+                return s;
+            case SS_FAILED:
+                delete s;
+                return NULL;
+            case SS_BRANCH:
+            default:
+            {
+                // Variables other than the relaxable ones are left to the neighborhood engine, within
+                // the limit of a neighborhood (no variable is relaxed, so it is not scaled)
+                neighborhood_branching(s);
+                e->reset(s);
+                if (params->deterministic() > 0)
+                    e_stop->limit(0, params->neighborNodes());
+                else if (params->neighborTime() > 0)
+                    e_stop->limit(static_cast<unsigned long int>(params->neighborTime()));
                 else
-                {
-                    e->reset(neighbor);
-                    TimeStop* t_stop = dynamic_cast<TimeStop*>(e_stop);
-
-                    // Set time limit
-                    if (lns_options->neighborTime() > 0) {
-                        double m = lns_options->perVariable() ? 1 : 0;
-                        dynamic_cast<TimeStop*>(e_stop)->limit(lns_options->neighborTime() * (relaxed_variables * m));
-                        dynamic_cast<TimeStop*>(e_stop)->reset();
-                    }
-                    else {
-                        // Run until a solutions has been found, but not past overall LNS stopping criterion
-                        e_stop = m_stop;
-                    }
+                    e_stop->limit(0);
+                e_stop->reset();
+                return e->next();
+            }
+        }
+    }
 
-                    // If we want to stop at first neighbour
-                    if (lns_options->stopAtFirstNeighbor())
-                    {
-                        n = e->next();
-                    }
-                    else
-                    {
-                        // Find all solutions until time is up
-                        std::list<Space*> prev_solutions;
-                        do
-                            prev_solutions.push_back(e->next());
-                        while (prev_solutions.back() != NULL);
-
-                        // Remove the last NULL solution if was generated by mistake
-                        if (prev_solutions.size() > 1)
-                            prev_solutions.pop_back();
-
-                        // Remove intermediate solutions, n is last solution
-                        n = prev_solutions.back();
-                        prev_solutions.pop_back();
-                        for (std::list<Space*>::iterator it = prev_solutions.begin(); it != prev_solutions.end(); it++)
-                            delete *it;
+    /*
+     * Every worker explores the same number of neighborhoods per epoch, with
+     * node (rather than time) limits. At the barrier the best incumbent is
+     * chosen in the order of the workers and handed to the workers whose
+     * current solution is worse, hence the search only depends on the seed.
+     */
+    Space*
+    LNS::epochs(void) {
+        unsigned int w = workers->engines.size();
+        while (true) {
+
+            // The best solution is (close enough to) optimal, or the overall search has been stopped
+            if (gap_closed() || (m_stop != NULL && m_stop->stop(statistics(), opt)))
+                return NULL;
+
+            std::vector<std::thread> threads;
+            for (unsigned int i = 0; i < w; i++)
+                threads.push_back(std::thread([this, i]() {
+                    LNS* l = workers->engines[i];
+                    for (unsigned int k = 0; k < params->epoch(); k++) {
+                        delete l->iterate();
+                        if (l->done())
+                            break;
                     }
+                }));
+            for (unsigned int i = 0; i < w; i++)
+                threads[i].join();
 
-                    // Restore e_stop if it has been changed
-                    if (e_stop == m_stop)
-                        e_stop = t_stop;
+            // Exchange the incumbents
+            Space* b = NULL;
+            bool running = false;
+            for (unsigned int i = 0; i < w; i++) {
+                LNS* l = workers->engines[i];
+                running = running || !l->done();
+                bound = std::max(bound, l->bound);
+                if (l->best != NULL && (b == NULL || dynamic_cast<LNSAbstractSpace*>(l->best)->improving(*b, true)))
+                    b = l->best;
+            }
+            if (b == NULL)
+            {
+                if (running)
+                    continue;
+                return NULL;
+            }
+            for (unsigned int i = 0; i < w; i++) {
+                LNS* l = workers->engines[i];
+                if (l->best != b && l->current != NULL && dynamic_cast<LNSAbstractSpace*>(b)->improving(*l->current, true))
+                    l->reset(b->clone(false));
+            }
 
-                }
+            LNSAbstractSpace* _b = dynamic_cast<LNSAbstractSpace*>(b);
+            if (best == NULL || _b->improving(*best, true))
+            {
+                metrics.improvement(_b->objective());
+                delete best;
+                best = b->clone(false);
+                return b->clone(false);
+            }
+            if (!running)
+                return NULL;
+        }
+        GECODE_NEVER;
 
-                // If found a neighbour
-                if (n != NULL)
-                {
-                    neighbors_accepted++;
-                    LNSAbstractSpace* _n = dynamic_cast<LNSAbstractSpace*>(n);
+        return NULL;
+    }
 
-                    // Improving move: replace current, reset search
-                    if (_n->improving(*best, true))
-                    {
-                        delete best;
-                        best = n->clone(shared);
-                        delete current;
-                        current = n->clone(shared);
-                        idle_iterations = 0;
-                        intensity = lns_options->minIntensity();
-                        return n;
-                    }
+    Space*
+    LNS::decompose(void) {
+        LNSAbstractSpace* _current = dynamic_cast<LNSAbstractSpace*>(current);
+        _current->assignment(values);
+        unsigned int n = values.size();
+        if (n == 0)
+            return NULL;
 
-                    // Side move: replace current, but do not reset search
-                    else if (lns_options->constrainType() == LNS_CT_SA || lns_options->constrainType() == LNS_CT_NONE || _n->improving(*current, lns_options->constrainType() == LNS_CT_STRICT))
+        // Grow disjoint clusters of (up to) intensity related variables from random seeds, the variables
+        // related to a cluster cannot be part of another one, so that the parts do not interact
+        const int FREE = -1, BLOCKED = -2;
+        unsigned int k = parts->engines.size();
+        cluster_of.assign(n, FREE);
+        clusters.resize(k);
+        unsigned int c = 0;
+        for (; c < k; c++)
+        {
+            std::vector<unsigned int>& cluster = clusters[c];
+            cluster.clear();
+            unsigned int first = relax_rnd(n), seed = n;
+            for (unsigned int i = 0; i < n && seed == n; i++)
+                if (cluster_of[(first + i) % n] == FREE)
+                    seed = (first + i) % n;
+            if (seed == n)
+                break;
+            cluster_of[seed] = c;
+            cluster.push_back(seed);
+            for (unsigned int q = 0; q < cluster.size() && cluster.size() < intensity; q++)
+            {
+                _current->related(cluster[q], related);
+                for (unsigned int j = 0; j < related.size() && cluster.size() < intensity; j++)
+                    if (related[j] < n && cluster_of[related[j]] == FREE)
                     {
-                        delete current;
-                        current = n->clone(shared);
-                        delete n;
-                        n = NULL;
+                        cluster_of[related[j]] = c;
+                        cluster.push_back(related[j]);
                     }
-                }
+            }
+            for (unsigned int q = 0; q < cluster.size(); q++)
+            {
+                _current->related(cluster[q], related);
+                for (unsigned int j = 0; j < related.size(); j++)
+                    if (related[j] < n && cluster_of[related[j]] == FREE)
+                        cluster_of[related[j]] = BLOCKED;
+            }
+        }
+        k = c;
 
-                // If the overall search has been stopped
-                if (m_stop != NULL && m_stop->stop(statistics(), opt))
+        // Each part frees one cluster and must improve on current, parts get unshared copies
+        for (c = 0; c < k; c++)
+        {
+            Space* s = root->clone(false);
+            LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
+            keep.assign(n, true);
+            for (unsigned int i = 0; i < clusters[c].size(); i++)
+                keep[clusters[c][i]] = false;
+            _s->fix(values, keep);
+            neighborhood_branching(s);
+            _s->constrain(*current, true, 0.0);
+            tracer->post(*s);
+            double m = params->perVariable() ? clusters[c].size() : 1;
+            parts->deadlines[c]->limit(static_cast<unsigned long int>(params->neighborTime() * m));
+            parts->deadlines[c]->reset();
+            parts->engines[c]->reset(s);
+        }
+        std::vector<Space*> found(k, NULL);
+        std::vector<std::thread> threads;
+        bool first = params->stopAtFirstNeighbor();
+        for (c = 0; c < k; c++)
+            threads.push_back(std::thread([this, &found, c, first]() {
+                Search::Engine* pe = parts->engines[c];
+                tracer->mark();
+                found[c] = pe->next();
+                Space* s;
+                while (!first && found[c] != NULL && (s = pe->next()) != NULL)
                 {
-                    // eventually ask to restart
-                    if (n != NULL)
-                        delete n;
-                    if (neighbor != NULL)
-                    {
-                        //cerr << "Neighbor is not null, and it's ok to erase it." << endl;
-                        //delete neighbor;
-                    }
-                    if (current != NULL)
-                        delete current;
-                    current = NULL;
-                    return NULL;
+                    if (dynamic_cast<LNSAbstractSpace*>(s)->improving(*found[c], true))
+                        std::swap(s, found[c]);
+                    delete s;
                 }
+            }));
+        for (c = 0; c < k; c++)
+            threads[c].join();
+
+        // The improved parts, best first
+        std::vector<std::pair<double, unsigned int> > improved;
+        std::vector<std::vector<int> > assignments(k);
+        for (c = 0; c < k; c++)
+            if (found[c] != NULL)
+            {
+                LNSAbstractSpace* _f = dynamic_cast<LNSAbstractSpace*>(found[c]);
+                _f->assignment(assignments[c]);
+                improved.push_back(std::make_pair(_f->objective() - _current->objective(), c));
+                delete found[c];
+            }
+        std::sort(improved.begin(), improved.end());
+        if (improved.empty())
+            return NULL;
+
+        // Merge all improvements, if they interfere merge greedily those that keep improving
+        std::vector<int> merged(values);
+        for (unsigned int i = 0; i < improved.size(); i++)
+        {
+            const std::vector<unsigned int>& cluster = clusters[improved[i].second];
+            for (unsigned int j = 0; j < cluster.size(); j++)
+                merged[cluster[j]] = assignments[improved[i].second][cluster[j]];
+        }
+        Space* m = complete(merged);
+        if (m != NULL && dynamic_cast<LNSAbstractSpace*>(m)->improving(*current, true))
+            return m;
+        delete m;
+        m = NULL;
+        merged = values;
+        for (unsigned int i = 0; i < improved.size(); i++)
+        {
+            std::vector<int> trial(merged);
+            const std::vector<unsigned int>& cluster = clusters[improved[i].second];
+            for (unsigned int j = 0; j < cluster.size(); j++)
+                trial[cluster[j]] = assignments[improved[i].second][cluster[j]];
+            Space* t = complete(trial);
+            if (t != NULL && dynamic_cast<LNSAbstractSpace*>(t)->improving(m != NULL ? *m : *current, true))
+            {
+                delete m;
+                m = t;
+                merged.swap(trial);
             }
-            idle_iterations++;
+            else
+                delete t;
         }
-        GECODE_NEVER;
+        return m;
+    }
 
-        return NULL;
+    /*
+     * A tree not deeper than the copying distance is recomputed from its
+     * root over and over, hence shallow trees are copied at every node. For
+     * trees much deeper than the copying distance, copying less often
+     * saves memory at a moderate recomputation cost. Without a reliable
+     * depth, the given distances are used.
+     */
+    void
+    LNS::choose_copies(unsigned int free) {
+        double expected = depth * std::max(1U, free);
+        if (!depth_reported)
+            e = copies[1];
+        else if (expected <= opt.c_d)
+            e = copies[0];
+        else if (expected <= 16.0 * opt.c_d)
+            e = copies[1];
+        else
+            e = copies[2];
+    }
+
+    void
+    LNS::prepost(void) {
+        if (root != NULL && params->dormantBranching())
+            dynamic_cast<LNSAbstractSpace*>(root)->dormant_branching(params->guided() != LNS_GUIDE_NONE);
+    }
+
+    /*
+     * Only the first variant of the initial solution branching is dormant
+     * in root, the others (e.g., when racing) are posted after killing it.
+     */
+    void
+    LNS::start_branching(Space* s, unsigned long int variant) {
+        LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
+        if (_s->dormant())
+        {
+            _s->kill_neighborhood_branching();
+            if (variant == 0)
+                return;
+            _s->kill_start_branching();
+        }
+        _s->initial_solution_branching(variant);
+    }
+
+    void
+    LNS::neighborhood_branching(Space* s) {
+        LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
+        if (_s->dormant())
+            _s->kill_start_branching();
+        else if (_s->guided())
+            _s->guided_branching();
+        else
+            _s->neighborhood_branching();
+    }
+
+    Space*
+    LNS::race(Space* s) {
+        unsigned int k = racers.size();
+        race_stop->reset();
+        // Every racer gets its own (unshared) copy and a different branching (unless the race is resumed)
+        if (s != NULL)
+        {
+            for (unsigned int i = 0; i < k; i++)
+            {
+                Space* c = s->clone(false);
+                start_branching(c, restart * k + i);
+                racers[i]->reset(c);
+            }
+            delete s;
+        }
+
+        // The first racer finding a solution ends the race, solutions found by the others
+        // before they notice compete with it
+        std::vector<Space*> found(k, NULL);
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < k; i++)
+            threads.push_back(std::thread([this, &found, i]() {
+                found[i] = racers[i]->next();
+                if (found[i] != NULL)
+                    race_stop->finish();
+            }));
+        for (unsigned int i = 0; i < k; i++)
+            threads[i].join();
+
+        Space* n = NULL;
+        for (unsigned int i = 0; i < k; i++)
+        {
+            if (found[i] == NULL)
+                continue;
+            if (n == NULL || dynamic_cast<LNSAbstractSpace*>(found[i])->improving(*n, true))
+            {
+                delete n;
+                n = found[i];
+            }
+            else
+                delete found[i];
+        }
+        return n;
+    }
+
+    bool
+    LNS::gap_closed(void) const {
+        if (best == NULL)
+            return false;
+        double cost = dynamic_cast<LNSAbstractSpace*>(best)->objective();
+        return cost - bound <= params->gap() * std::fabs(cost);
     }
 
     Search::Statistics
     LNS::statistics(void) const {
-        return stats + e->statistics();
+        Search::Statistics s = stats;
+        if (copies.empty())
+            s += e->statistics();
+        for (unsigned int i = 0; i < copies.size(); i++)
+            s += copies[i]->statistics();
+        if (parts != NULL)
+            for (unsigned int i = 0; i < parts->engines.size(); i++)
+                s += parts->engines[i]->statistics();
+        if (workers != NULL)
+            for (unsigned int i = 0; i < workers->engines.size(); i++)
+                s += workers->engines[i]->statistics();
+        return s;
     }
 
     bool
@@ -296,24 +956,85 @@ namespace Gecode { namespace Search { namespace Meta {
 
     void
     LNS::reset(Space* s) {
+        delete current;
         current = s;
+        starting = false;
         LNSAbstractSpace* _s = dynamic_cast<LNSAbstractSpace*>(s);
-        if (best && _s->improving(*best, true))
+        if (best == NULL || _s->improving(*best, true))
         {
             delete best;
             best = s->clone(shared);
         }
         idle_iterations = 0;
-        intensity = lns_options->minIntensity();
+        intensity = params->minIntensity();
+        neighbors_accepted = 0;
+        temperature = params->SAstartTemperature();
+    }
+
+    /*
+     * The sub-engines are reset with every search they perform, hence only
+     * the state of the meta-engine (and of its workers) has to be cleared.
+     */
+    void
+    LNS::reinit(Space* s) {
+        root = s;
+        delete best;
+        best = NULL;
+        delete current;
+        current = NULL;
+        for (unsigned int i = 0; i < elite.size(); i++)
+            delete elite[i];
+        elite.clear();
+        elite_values.clear();
+        relatedness = LNSRelatedness();
+        restart = 0;
+        idle_iterations = 0;
+        iterations = 0;
         neighbors_accepted = 0;
-        temperature = lns_options->SAstartTemperature();
+        halted = false;
+        starting = false;
+        bound = root != NULL ? dynamic_cast<LNSAbstractSpace*>(root)->lower_bound() : -std::numeric_limits<double>::infinity();
+        // Workers pre-post in their own roots
+        if (workers != NULL)
+            for (unsigned int i = 0; i < workers->engines.size(); i++) {
+                Space* w = root != NULL ? root->clone(false) : NULL;
+                workers->engines[i]->reinit(w);
+                delete workers->roots[i];
+                workers->roots[i] = w;
+            }
+        prepost();
     }
 
     LNS::~LNS(void) {
+        profile.print(std::cerr);
+        propagators.print(std::cerr);
+        delete best;
+        delete current;
+        for (unsigned int i = 0; i < elite.size(); i++)
+            delete elite[i];
+        for (unsigned int i = 0; i < racers.size(); i++)
+            delete racers[i];
+        delete race_stop;
+        delete parts;
+        delete workers;
         // Deleting e also deletes stop
-        delete e;
+        if (copies.empty())
+            delete e;
+        for (unsigned int i = 0; i < copies.size(); i++)
+            delete copies[i];
+    }
+
+}
+
+    LNSWorkers::~LNSWorkers(void) {
+        for (unsigned int i = 0; i < engines.size(); i++) {
+            delete engines[i];
+            delete stops[i];
+            delete deadlines[i];
+            delete roots[i];
+        }
     }
 
-}}}
+}}
 
 // STATISTICS: search-other
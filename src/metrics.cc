@@ -0,0 +1,261 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "gecode-lns/metrics.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/time.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Gecode { namespace Search { namespace Meta {
+
+    /**
+     * The exporter shared by all published metrics: a thread per endpoint
+     * answers every connection with a Prometheus text exposition of the
+     * current snapshots of all published engines.
+     */
+    class LNSMetricsExporter {
+    protected:
+        std::mutex m;
+        std::vector<const LNSMetrics*> published;
+        unsigned long int ids;
+        unsigned int port;
+        std::string path;
+
+        /** The exposition of all published metrics */
+        std::string exposition(void) {
+            std::vector<LNSMetrics::Snapshot> s;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                for (unsigned int i = 0; i < published.size(); i++)
+                    s.push_back(published[i]->snapshot());
+            }
+            std::ostringstream os;
+            metric(os, s, "lns_iterations_total", "counter", "Neighborhoods explored", &LNSMetrics::Snapshot::iterations);
+            metric(os, s, "lns_iterations_per_second", "gauge", "Neighborhoods explored per second over the last seconds (see LNSMetrics::window)", &LNSMetrics::Snapshot::iterations_per_second);
+            metric(os, s, "lns_intensity", "gauge", "Current intensity", &LNSMetrics::Snapshot::intensity);
+            metric(os, s, "lns_temperature", "gauge", "Current temperature", &LNSMetrics::Snapshot::temperature);
+            metric(os, s, "lns_best_cost", "gauge", "Cost of the best solution", &LNSMetrics::Snapshot::best);
+            metric(os, s, "lns_improvements_total", "counter", "Improvements of the best solution", &LNSMetrics::Snapshot::improvements);
+            metric(os, s, "lns_nodes_total", "counter", "Nodes explored by the sub-engines", &LNSMetrics::Snapshot::node);
+            metric(os, s, "lns_fails_total", "counter", "Failures of the sub-engines", &LNSMetrics::Snapshot::fail);
+            metric(os, s, "lns_seconds_since_improvement", "gauge", "Seconds since the last improvement", &LNSMetrics::Snapshot::since_improvement);
+            metric(os, s, "lns_elapsed_seconds", "gauge", "Seconds since the engine has been created", &LNSMetrics::Snapshot::elapsed);
+            return os.str();
+        }
+
+        template <class T>
+        static void metric(std::ostream& os, const std::vector<LNSMetrics::Snapshot>& s,
+                           const char* name, const char* type, const char* help, T LNSMetrics::Snapshot::* field) {
+            os << "# HELP " << name << " " << help << "\n"
+               << "# TYPE " << name << " " << type << "\n";
+            for (unsigned int i = 0; i < s.size(); i++)
+            {
+                os << name << "{engine=\"" << s[i].id << "\"} ";
+                value(os, s[i].*field);
+                os << "\n";
+            }
+        }
+
+        template <class T>
+        static void value(std::ostream& os, T v) {
+            os << v;
+        }
+
+        static void value(std::ostream& os, double v) {
+            if (std::isnan(v))
+                os << "NaN";
+            else
+                os << v;
+        }
+
+#ifndef _WIN32
+        /** Answer the connections to socket \a fd (until it cannot accept them any more) */
+        void serve(int fd) {
+            while (true) {
+                int c = accept(fd, NULL, NULL);
+                if (c < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED)
+                        continue;
+                    // Out of descriptors or memory: back off until some are released
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                        continue;
+                    }
+                    std::cerr << "LNS: stopped serving metrics: " << std::strerror(errno) << std::endl;
+                    close(fd);
+                    return;
+                }
+                // A stalled client must not block the others
+                timeval timeout;
+                timeout.tv_sec = 1;
+                timeout.tv_usec = 0;
+                setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                setsockopt(c, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                // The request itself does not matter
+                char request[1024];
+                if (recv(c, request, sizeof(request), 0) >= 0) {
+                    std::string body = exposition();
+                    std::ostringstream response;
+                    response << "HTTP/1.0 200 OK\r\n"
+                             << "Content-Type: text/plain; version=0.0.4\r\n"
+                             << "Content-Length: " << body.size() << "\r\n\r\n"
+                             << body;
+                    std::string r = response.str();
+                    for (size_t sent = 0; sent < r.size(); ) {
+                        ssize_t k = send(c, r.data() + sent, r.size() - sent, MSG_NOSIGNAL);
+                        if (k <= 0)
+                            break;
+                        sent += k;
+                    }
+                }
+                close(c);
+            }
+        }
+
+        /** Start answering on socket \a fd bound to \a a, return whether it succeeded */
+        bool listen(int fd, const sockaddr* a, socklen_t l, const std::string& endpoint) {
+            if (fd < 0 || bind(fd, a, l) < 0 || ::listen(fd, 16) < 0) {
+                std::cerr << "LNS: cannot serve metrics on " << endpoint << ": " << std::strerror(errno) << std::endl;
+                if (fd >= 0)
+                    close(fd);
+                return false;
+            }
+            std::thread t(&LNSMetricsExporter::serve, this, fd);
+            t.detach();
+            return true;
+        }
+#endif
+
+        /** Start the endpoints not yet listening (lock must be held) */
+        void open(unsigned int port0, const char* path0) {
+#ifndef _WIN32
+            if (port0 != 0 && port == 0) {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                int yes = 1;
+                if (fd >= 0)
+                    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+                sockaddr_in a;
+                std::memset(&a, 0, sizeof(a));
+                a.sin_family = AF_INET;
+                a.sin_port = htons(port0);
+                a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                std::ostringstream endpoint;
+                endpoint << "127.0.0.1:" << port0;
+                if (listen(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a), endpoint.str()))
+                    port = port0;
+            }
+            if (path0 != NULL && *path0 != '\0' && path.empty()) {
+                sockaddr_un a;
+                std::memset(&a, 0, sizeof(a));
+                a.sun_family = AF_UNIX;
+                std::strncpy(a.sun_path, path0, sizeof(a.sun_path) - 1);
+                unlink(path0);
+                if (listen(socket(AF_UNIX, SOCK_STREAM, 0), reinterpret_cast<sockaddr*>(&a), sizeof(a), path0))
+                    path = path0;
+            }
+#else
+            (void) port0;
+            (void) path0;
+#endif
+        }
+
+    public:
+        LNSMetricsExporter(void) : ids(0), port(0) {}
+
+        /** Publish \a s on \a port0 and/or \a path0 */
+        void add(LNSMetrics* s, unsigned int port0, const char* path0) {
+            std::lock_guard<std::mutex> lock(m);
+            open(port0, path0);
+            s->id = ++ids;
+            published.push_back(s);
+        }
+
+        /** Withdraw \a s */
+        void remove(const LNSMetrics* s) {
+            std::lock_guard<std::mutex> lock(m);
+            published.erase(std::remove(published.begin(), published.end(), s), published.end());
+        }
+
+        /** The exporter (never destroyed, as its threads run until the process ends) */
+        static LNSMetricsExporter& exporter(void) {
+            static LNSMetricsExporter* e = new LNSMetricsExporter();
+            return *e;
+        }
+    };
+
+    LNSMetrics::LNSMetrics(unsigned int port, const char* path)
+      : id(0), published(port != 0 || (path != NULL && *path != '\0')), start(Clock::now()),
+        _iterations(0), _intensity(0), _temperature(0.0),
+        _best(std::numeric_limits<double>::quiet_NaN()), _improvements(0),
+        _node(0), _fail(0), _improved(0) {
+        for (unsigned int i = 0; i < window; i++) {
+            _mark_time[i] = -1;
+            _mark_iterations[i] = 0;
+        }
+        if (published)
+            LNSMetricsExporter::exporter().add(this, port, path);
+    }
+
+    LNSMetrics::~LNSMetrics(void) {
+        if (published)
+            LNSMetricsExporter::exporter().remove(this);
+    }
+
+    LNSMetrics::Snapshot
+    LNSMetrics::snapshot(void) const {
+        Snapshot s;
+        long long int now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        s.id = id;
+        s.elapsed = now / 1e9;
+        s.iterations = _iterations.load(std::memory_order_relaxed);
+        // Rate since the oldest mark still within the window (none: no iteration lately)
+        s.iterations_per_second = 0.0;
+        long long int oldest = now;
+        unsigned long int since = s.iterations;
+        for (unsigned int i = 0; i < window; i++) {
+            long long int t = _mark_time[i].load(std::memory_order_acquire);
+            if (t >= 0 && t < oldest && now - t <= window * 1000000000LL) {
+                oldest = t;
+                since = _mark_iterations[i].load(std::memory_order_relaxed);
+            }
+        }
+        if (oldest < now && s.iterations >= since)
+            s.iterations_per_second = (s.iterations - since) / ((now - oldest) / 1e9);
+        s.intensity = _intensity.load(std::memory_order_relaxed);
+        s.temperature = _temperature.load(std::memory_order_relaxed);
+        s.best = _best.load(std::memory_order_relaxed);
+        s.improvements = _improvements.load(std::memory_order_relaxed);
+        s.node = _node.load(std::memory_order_relaxed);
+        s.fail = _fail.load(std::memory_order_relaxed);
+        s.since_improvement = (now - _improved.load(std::memory_order_relaxed)) / 1e9;
+        return s;
+    }
+
+}}}
+
+// STATISTICS: search-other
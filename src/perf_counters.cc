@@ -0,0 +1,133 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include <gecode/kernel.hh>
+#include "gecode-lns/perf_counters.hh"
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Gecode { namespace Search { namespace Meta {
+
+#ifdef __linux__
+    /** Open a hardware counter of the calling thread, in the group of \a group (or as a new leader) */
+    static int
+    open_counter(unsigned long long config, int group) {
+        struct perf_event_attr pe;
+        std::memset(&pe, 0, sizeof(pe));
+        pe.type = PERF_TYPE_HARDWARE;
+        pe.size = sizeof(pe);
+        pe.config = config;
+        pe.disabled = (group == -1);
+        pe.exclude_kernel = 1;
+        pe.exclude_hv = 1;
+        pe.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(__NR_perf_event_open, &pe, 0, -1, group, 0));
+    }
+#endif
+
+    PerfCounters::PerfCounters(bool enabled0)
+      : enabled(enabled0), leader(-1), opened(0) {
+        for (int c = 0; c < COUNTERS; c++) {
+            slot[c] = -1;
+            fd[c] = -1;
+            start[c] = 0;
+        }
+        for (int p = 0; p < LNS_PHASES; p++) {
+            for (int c = 0; c < COUNTERS; c++)
+                total[p][c] = 0;
+            total_time[p] = 0;
+            calls[p] = 0;
+        }
+#ifdef __linux__
+        if (!enabled)
+            return;
+        const unsigned long long config[COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (int c = 0; c < COUNTERS; c++) {
+            fd[c] = open_counter(config[c], leader);
+            if (fd[c] < 0)
+                continue;
+            if (leader == -1)
+                leader = fd[c];
+            slot[c] = opened++;
+        }
+        if (leader != -1) {
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    PerfCounters::~PerfCounters(void) {
+#ifdef __linux__
+        for (int c = COUNTERS; c--; )
+            if (fd[c] >= 0)
+                close(fd[c]);
+#endif
+    }
+
+    void
+    PerfCounters::read(unsigned long long v[COUNTERS]) const {
+        for (int c = 0; c < COUNTERS; c++)
+            v[c] = 0;
+#ifdef __linux__
+        if (leader == -1)
+            return;
+        // Layout of PERF_FORMAT_GROUP: number of values followed by the values
+        unsigned long long buffer[COUNTERS + 1];
+        if (::read(leader, buffer, sizeof(unsigned long long) * (opened + 1)) <= 0)
+            return;
+        for (int c = 0; c < COUNTERS; c++)
+            if (slot[c] >= 0)
+                v[c] = buffer[slot[c] + 1];
+#endif
+    }
+
+    void
+    PerfCounters::print(std::ostream& os) const {
+        if (!enabled)
+            return;
+        static const char* phase[LNS_PHASES] = { "clone", "relax", "propagate", "search", "polish", "accept" };
+        static const char* counter[COUNTERS] = { "cycles", "instructions", "cache-misses", "branch-misses" };
+        os << "LNS phase profile:" << std::endl;
+        os << "\t" << std::setw(10) << "phase" << std::setw(12) << "calls" << std::setw(14) << "time (ms)";
+        for (int c = 0; c < COUNTERS; c++)
+            os << std::setw(16) << counter[c];
+        os << std::setw(8) << "IPC" << std::endl;
+        for (int p = 0; p < LNS_PHASES; p++) {
+            os << "\t" << std::setw(10) << phase[p] << std::setw(12) << calls[p]
+               << std::setw(14) << std::fixed << std::setprecision(3) << total_time[p] / 1e6;
+            for (int c = 0; c < COUNTERS; c++)
+                if (available(static_cast<Counter>(c)))
+                    os << std::setw(16) << total[p][c];
+                else
+                    os << std::setw(16) << "n/a";
+            if (available(CYCLES) && available(INSTRUCTIONS) && total[p][CYCLES] > 0)
+                os << std::setw(8) << std::setprecision(2) << (double) total[p][INSTRUCTIONS] / total[p][CYCLES];
+            else
+                os << std::setw(8) << "n/a";
+            os << std::endl;
+        }
+    }
+
+}}}
+
+// STATISTICS: search-other
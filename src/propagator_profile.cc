@@ -0,0 +1,128 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "gecode-lns/propagator_profile.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <typeinfo>
+#include <vector>
+#include <cxxabi.h>
+
+namespace Gecode { namespace Search { namespace Meta {
+
+    /** Return the demangled name of the dynamic type of \a p */
+    static std::string
+    type_name(const Propagator& p) {
+        const char* mangled = typeid(p).name();
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+        std::string name(status == 0 && demangled != NULL ? demangled : mangled);
+        std::free(demangled);
+        return name;
+    }
+
+    PropagatorProfile::Clock::time_point&
+    PropagatorProfile::last(void) {
+        static thread_local Clock::time_point t = Clock::now();
+        return t;
+    }
+
+    PropagatorProfile::PropagatorProfile(bool enabled0)
+      : enabled(enabled0) {}
+
+    void
+    PropagatorProfile::post(Space& home) {
+        if (enabled)
+            trace(home, TE_PROPAGATE | TE_COMMIT, *this);
+    }
+
+    void
+    PropagatorProfile::mark(void) {
+        if (enabled)
+            last() = Clock::now();
+    }
+
+    /*
+     * Ids are reused by propagators created in different copies, hence the
+     * cached type is checked, which only compares the type_info objects.
+     * Entries are never erased, so the cached pointers stay valid.
+     */
+    PropagatorProfile::Entry&
+    PropagatorProfile::entry(unsigned int id, const Propagator* p) {
+        Kind& k = kinds[id];
+        if (p == NULL)
+        {
+            if (k.entry == NULL)
+                k.entry = &entries["(subsumed before being seen)"];
+            return *k.entry;
+        }
+        if (k.type == NULL || *k.type != typeid(*p))
+        {
+            k.type = &typeid(*p);
+            k.entry = &entries[type_name(*p)];
+        }
+        return *k.entry;
+    }
+
+    void
+    PropagatorProfile::propagate(const Space&, const PropagateTraceInfo& pti) {
+        Clock::time_point t = Clock::now();
+        unsigned long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t - last()).count();
+        {
+            std::lock_guard<std::mutex> lock(m);
+            Entry& e = entry(pti.id(), pti.propagator());
+            e.calls++;
+            e.time += ns;
+            e.outcome[pti.status()]++;
+        }
+        last() = Clock::now();
+    }
+
+    void
+    PropagatorProfile::commit(const Space&, const CommitTraceInfo&) {
+        last() = Clock::now();
+    }
+
+    /** Order entries by decreasing time */
+    static bool
+    slower(const std::pair<std::string, unsigned long long>& a, const std::pair<std::string, unsigned long long>& b) {
+        return a.second > b.second;
+    }
+
+    void
+    PropagatorProfile::print(std::ostream& os) const {
+        if (!enabled)
+            return;
+        std::vector<std::pair<std::string, unsigned long long> > order;
+        for (std::map<std::string, Entry>::const_iterator i = entries.begin(); i != entries.end(); i++)
+            order.push_back(std::make_pair(i->first, i->second.time));
+        std::stable_sort(order.begin(), order.end(), slower);
+        os << "LNS propagator profile:" << std::endl;
+        os << "\t" << std::setw(14) << "calls" << std::setw(14) << "time (ms)"
+           << std::setw(14) << "fix" << std::setw(14) << "nofix" << std::setw(14) << "failed" << std::setw(14) << "subsumed"
+           << "  propagator" << std::endl;
+        for (unsigned int i = 0; i < order.size(); i++) {
+            const Entry& e = entries.find(order[i].first)->second;
+            os << "\t" << std::setw(14) << e.calls
+               << std::setw(14) << std::fixed << std::setprecision(3) << e.time / 1e6
+               << std::setw(14) << e.outcome[PropagateTraceInfo::FIX]
+               << std::setw(14) << e.outcome[PropagateTraceInfo::NOFIX]
+               << std::setw(14) << e.outcome[PropagateTraceInfo::FAILED]
+               << std::setw(14) << e.outcome[PropagateTraceInfo::SUBSUMED]
+               << "  " << order[i].first << std::endl;
+        }
+    }
+
+}}}
+
+// STATISTICS: search-other
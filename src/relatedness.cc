@@ -0,0 +1,103 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "gecode-lns/relatedness.hh"
+#include <algorithm>
+
+namespace Gecode { namespace Search { namespace Meta {
+
+    void
+    LNSRelatedness::resize(unsigned int n0) {
+        n = n0;
+        dense.clear();
+        sparse.clear();
+        if (n <= dense_limit)
+            dense.assign(n * n, 0.0f);
+        else
+            sparse.resize(n);
+        score.assign(n, 0.0);
+    }
+
+    void
+    LNSRelatedness::observe(const std::vector<int>& a, const std::vector<int>& b) {
+        if (a.size() != b.size() || a.empty())
+            return;
+        if (a.size() != n)
+            resize(a.size());
+        changed.clear();
+        for (unsigned int i = 0; i < n; i++)
+            if (a[i] != b[i])
+                changed.push_back(i);
+        if (changed.size() < 2 || changed.size() > max_changed)
+            return;
+        float w = 1.0f / changed.size();
+        for (unsigned int x = 0; x < changed.size(); x++)
+            for (unsigned int y = 0; y < changed.size(); y++)
+                if (x != y) {
+                    if (dense.empty())
+                        sparse[changed[x]][changed[y]] += w;
+                    else
+                        dense[changed[x] * n + changed[y]] += w;
+                }
+    }
+
+    void
+    LNSRelatedness::spread(unsigned int i) {
+        if (dense.empty()) {
+            for (std::unordered_map<unsigned int, float>::const_iterator j = sparse[i].begin(); j != sparse[i].end(); j++) {
+                if (score[j->first] == 0.0)
+                    touched.push_back(j->first);
+                score[j->first] += j->second;
+            }
+        } else {
+            const float* row = &dense[i * n];
+            for (unsigned int j = 0; j < n; j++)
+                if (row[j] > 0.0f) {
+                    if (score[j] == 0.0)
+                        touched.push_back(j);
+                    score[j] += row[j];
+                }
+        }
+    }
+
+    unsigned int
+    LNSRelatedness::grow(unsigned int n0, unsigned int k, LNSRandom& r, std::vector<bool>& keep) {
+        if (n0 != n)
+            resize(n0);
+        keep.assign(n, true);
+        score.assign(n, 0.0);
+        touched.clear();
+        k = std::min(k, n);
+        for (unsigned int f = 0; f < k; f++) {
+            // The kept variable most related to the freed ones
+            int next = -1;
+            for (unsigned int t = 0; t < touched.size(); t++)
+                if (keep[touched[t]] && (next == -1 || score[touched[t]] > score[next]))
+                    next = touched[t];
+            // None, start from a random kept variable
+            if (next == -1) {
+                unsigned int s = r(n - f);
+                for (unsigned int i = 0; i < n; i++)
+                    if (keep[i] && s-- == 0) {
+                        next = i;
+                        break;
+                    }
+            }
+            keep[next] = false;
+            spread(next);
+        }
+        return k;
+    }
+
+}}}
+
+// STATISTICS: search-other
@@ -0,0 +1,125 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "gecode-lns/thread_pool.hh"
+
+namespace Gecode { namespace Search {
+
+    /** The pool (and worker index) the calling thread belongs to */
+    static thread_local WorkStealingPool* this_pool = NULL;
+    static thread_local unsigned int this_worker = 0;
+
+    WorkStealingPool::WorkStealingPool(unsigned int n)
+      : queued(0), running(0), quit(false), next(0) {
+        if (n == 0)
+            n = 1;
+        for (unsigned int w = 0; w < n; w++)
+            workers.push_back(new Worker());
+        for (unsigned int w = 0; w < n; w++)
+            threads.push_back(std::thread(&WorkStealingPool::run, this, w));
+    }
+
+    WorkStealingPool::~WorkStealingPool(void) {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(m);
+            quit = true;
+        }
+        work.notify_all();
+        for (unsigned int w = 0; w < threads.size(); w++)
+            threads[w].join();
+        for (unsigned int w = 0; w < workers.size(); w++)
+            delete workers[w];
+    }
+
+    void
+    WorkStealingPool::submit(const Task& t) {
+        // Account for the task before it can be taken
+        {
+            std::lock_guard<std::mutex> lock(m);
+            queued++;
+        }
+        Worker* w;
+        if (this_pool == this)
+            w = workers[this_worker];
+        else {
+            std::lock_guard<std::mutex> lock(m);
+            w = workers[next++ % workers.size()];
+        }
+        {
+            std::lock_guard<std::mutex> lock(w->m);
+            w->tasks.push_back(t);
+        }
+        work.notify_one();
+    }
+
+    bool
+    WorkStealingPool::take(unsigned int w, Task& t) {
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(workers[w]->m);
+            if (!workers[w]->tasks.empty()) {
+                t = workers[w]->tasks.back();
+                workers[w]->tasks.pop_back();
+                found = true;
+            }
+        }
+        for (unsigned int i = 1; !found && i < workers.size(); i++) {
+            Worker* v = workers[(w + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(v->m);
+            if (!v->tasks.empty()) {
+                t = v->tasks.front();
+                v->tasks.pop_front();
+                found = true;
+            }
+        }
+        if (found) {
+            std::lock_guard<std::mutex> lock(m);
+            queued--;
+            running++;
+        }
+        return found;
+    }
+
+    void
+    WorkStealingPool::run(unsigned int w) {
+        this_pool = this;
+        this_worker = w;
+        while (true) {
+            Task t;
+            if (take(w, t)) {
+                t();
+                std::lock_guard<std::mutex> lock(m);
+                running--;
+                if (queued == 0 && running == 0)
+                    done.notify_all();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m);
+            if (quit)
+                return;
+            // A task may be in flight between being counted and being pushed: retry then
+            if (queued == 0)
+                work.wait(lock);
+        }
+    }
+
+    void
+    WorkStealingPool::wait(void) {
+        std::unique_lock<std::mutex> lock(m);
+        while (queued > 0 || running > 0)
+            done.wait(lock);
+    }
+
+}}
+
+// STATISTICS: search-other
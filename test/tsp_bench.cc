@@ -0,0 +1,175 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+/*
+ *  Main authors:
+ *     Luca Di Gaspero <luca.digaspero@uniud.it>
+ *     Tommaso Urli <tommaso.urli@uniud.it>
+ *
+ *  Copyright:
+ *     Luca Di Gaspero, Tommaso Urli, 2013
+ *
+ *
+ */
+
+#include "tsp.hh"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/**
+ * \brief Micro-benchmark of the steps of an LNS iteration on the %TSP model
+ *
+ * For random euclidean instances of growing size, measures the cost of
+ * cloning root, relaxing the current solution (at several intensities),
+ * propagating a fresh neighbor, constraining its cost and posting its
+ * branching. Every step is timed in isolation, on spaces prepared
+ * beforehand: each of the -samples samples times -iterations operations,
+ * and the mean and standard deviation of the samples are reported in
+ * nanoseconds per operation.
+ */
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  /// Mean and standard deviation of a measure
+  class Measure {
+  public:
+    double mean;
+    double stddev;
+  };
+
+  /**
+   * \brief Time operation \a op on spaces made by \a prepare
+   *
+   * The spaces of a sample are prepared (and deleted) outside of the timed
+   * region.
+   */
+  template<class Prepare, class Op>
+  Measure
+  measure(unsigned int samples, unsigned int iterations, Prepare prepare, Op op) {
+    std::vector<double> ns(samples);
+    std::vector<TSP*> s(iterations);
+    for (unsigned int k = 0; k < samples; k++) {
+      for (unsigned int i = 0; i < iterations; i++)
+        s[i] = prepare();
+      Clock::time_point t0 = Clock::now();
+      for (unsigned int i = 0; i < iterations; i++)
+        op(s[i]);
+      Clock::time_point t1 = Clock::now();
+      ns[k] = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+      for (unsigned int i = 0; i < iterations; i++)
+        delete s[i];
+    }
+    Measure m;
+    m.mean = 0;
+    for (unsigned int k = 0; k < samples; k++)
+      m.mean += ns[k];
+    m.mean /= samples;
+    m.stddev = 0;
+    for (unsigned int k = 0; k < samples; k++)
+      m.stddev += (ns[k] - m.mean) * (ns[k] - m.mean);
+    m.stddev = samples > 1 ? std::sqrt(m.stddev / (samples - 1)) : 0;
+    return m;
+  }
+
+  void
+  report(unsigned int n, const std::string& op, const Measure& m) {
+    std::cout << std::setw(6) << n << "  " << std::left << std::setw(20) << op << std::right
+              << std::setw(14) << std::fixed << std::setprecision(1) << m.mean
+              << " +- " << std::setw(10) << m.stddev << " ns/op" << std::endl;
+  }
+
+}
+
+/** \brief Main-function
+ *  \relates TSP
+ */
+int
+main(int argc, char* argv[]) {
+  TSPOptions opt("TSP benchmark");
+  opt.ipl(IPL_DOM);
+  opt.samples(10);
+  opt.iterations(100);
+  opt.model(TSP::MODEL_SPARSE);
+  opt.model(TSP::MODEL_DENSE, "dense", "full successor domains and cost table");
+  opt.model(TSP::MODEL_SPARSE, "sparse", "nearest neighbor successor domains and sparse cost table");
+  opt.parse(argc,argv);
+  Gecode::Search::Meta::LNS::lns_options = &opt;
+
+  // A single size if requested, otherwise growing ones
+  std::vector<unsigned int> sizes;
+  if (opt.nodes() > 0)
+    sizes.push_back(opt.nodes());
+  else
+    for (unsigned int n = 25; n <= 400; n *= 2)
+      sizes.push_back(n);
+
+  const unsigned int intensities[] = { 2, 8, 32 };
+  unsigned int samples = opt.samples(), iterations = opt.iterations();
+
+  for (unsigned int z = 0; z < sizes.size(); z++) {
+    unsigned int n = sizes[z];
+    opt.nodes(n);
+
+    // The root and a current solution, as found by the initial solution search
+    TSP* root = new TSP(opt);
+    if (root->status() == SS_FAILED) {
+      std::cerr << "Error: instance with " << n << " nodes is infeasible" << std::endl;
+      delete root;
+      return 1;
+    }
+    TSP* start = static_cast<TSP*>(root->clone());
+    start->initial_solution_branching(0);
+    TSP* current;
+    {
+      DFS<TSP> e(start);
+      current = e.next();
+    }
+    delete start;
+    if (current == NULL) {
+      std::cerr << "Error: no solution found for " << n << " nodes" << std::endl;
+      delete root;
+      return 1;
+    }
+
+    Rnd r(1U);
+    LNSRandom rnd(r);
+    unsigned int free = std::min(intensities[1], n);
+
+    // A fresh neighbor, relaxed unless asked otherwise
+    auto neighbor = [&](bool relaxed) {
+      TSP* s = static_cast<TSP*>(root->clone());
+      if (relaxed)
+        current->relax(s, free, rnd);
+      return s;
+    };
+
+    report(n, "clone", measure(samples, iterations,
+                               [&]() { return static_cast<TSP*>(NULL); },
+                               [&](TSP*& s) { s = static_cast<TSP*>(root->clone()); }));
+    for (unsigned int i = 0; i < sizeof(intensities) / sizeof(unsigned int); i++) {
+      unsigned int k = std::min(intensities[i], n);
+      report(n, "relax(" + std::to_string(k) + ")",
+             measure(samples, iterations,
+                     [&]() { return neighbor(false); },
+                     [&](TSP*& s) { current->relax(s, k, rnd); }));
+    }
+    report(n, "status", measure(samples, iterations,
+                                [&]() { return neighbor(true); },
+                                [&](TSP*& s) { s->status(); }));
+    report(n, "constrain", measure(samples, iterations,
+                                   [&]() { return neighbor(true); },
+                                   [&](TSP*& s) { s->constrain(*current, true, 0.0); }));
+    report(n, "branching", measure(samples, iterations,
+                                   [&]() { return neighbor(true); },
+                                   [&](TSP*& s) { s->neighborhood_branching(); }));
+
+    delete current;
+    delete root;
+  }
+
+  return 0;
+}
+
+// STATISTICS: example-any